@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <boost/interprocess/allocators/allocator.hpp>
+#include <boost/interprocess/containers/vector.hpp>
+
+#include "bitvector_kernels.hpp"
+
+
+namespace sdm {
+
+  namespace mms {
+
+    namespace bip = boost::interprocess;
+
+    //////////////////////////////////////////////////////////////////////
+    /// bit_postings - inverted index from each dimension of a space to
+    ///                the ascending ids of the symbols with that bit set
+    ///
+    /// superpose only changes the bits of the source's elemental basis so
+    /// those postings alone are refiled on learning; a symbol of which
+    /// nothing is known is refiled over every dimension. Queries for the
+    /// symbols holding some set of bits merge a handful of postings
+    /// rather than scanning every vector.
+    //////////////////////////////////////////////////////////////////////
+
+    template <typename segment_manager_t>
+
+    class bit_postings final {
+
+    public:
+
+      typedef bip::allocator<void, segment_manager_t> void_allocator_t;
+      typedef kernels::word_t word_t;
+      typedef bip::vector<std::uint32_t, bip::allocator<std::uint32_t, segment_manager_t>> posting_t;
+
+    private:
+
+      typedef bip::vector<posting_t, bip::allocator<posting_t, segment_manager_t>> postings_t;
+
+    public:
+
+      /// postings for vectors of d dimensions
+
+      bit_postings(const std::size_t d, const void_allocator_t& a) : filed(0), lists(a) {
+        lists.reserve(d);
+        for (std::size_t i = 0; i < d; ++i) lists.emplace_back(a);
+      }
+
+
+      /// number of dimensions
+      inline std::size_t dimensions() const { return lists.size(); }
+
+      /// ids with bit set
+      inline const posting_t& posting(const std::size_t bit) const { return lists[bit]; }
+
+
+      /// file every bit of vector v as symbol id
+
+      void file(const std::uint32_t id, const word_t* v) {
+        if (id >= filed) {
+          // never filed so there is nothing to take out
+          for (std::size_t w = 0; w < dimensions() / 64; ++w)
+            for (word_t x = v[w]; x; x &= x - 1) add(lists[w * 64 + __builtin_ctzll(x)], id);
+          filed = id + 1;
+
+        } else {
+          for (std::size_t bit = 0; bit < dimensions(); ++bit) refile(id, v, bit);
+        }
+      }
+
+
+      /// refile only the bits of vector v that a basis of n indices
+      /// rotated as in superpose_basis could have changed
+
+      void file_basis(const std::uint32_t id,
+                      const word_t* v,
+                      const unsigned* basis,
+                      const std::size_t n,
+                      const int rotations) {
+        if (id >= filed) return file(id, v);
+        for (auto it = basis; it < basis + n; ++it) refile(id, v, (*it + rotations) % dimensions());
+      }
+
+
+      /// refile only the bits of vector v set in mask
+
+      void file_mask(const std::uint32_t id, const word_t* v, const word_t* mask) {
+        if (id >= filed) return file(id, v);
+        for (std::size_t w = 0; w < dimensions() / 64; ++w)
+          for (word_t x = mask[w]; x; x &= x - 1) refile(id, v, w * 64 + __builtin_ctzll(x));
+      }
+
+
+      /// count how many of n bits each id has set, visiting ids with no
+      /// fewer than least of them in ascending id order as f(id, count)
+
+      template <typename F>
+      void overlap(const std::size_t* bits, const std::size_t n, const std::size_t least, F f) const {
+        std::vector<std::uint32_t> ids;
+        for (std::size_t i = 0; i < n; ++i) ids.insert(ids.end(), lists[bits[i]].begin(), lists[bits[i]].end());
+        std::sort(ids.begin(), ids.end());
+
+        for (std::size_t i = 0; i < ids.size();) {
+          std::size_t j = i + 1;
+          while (j < ids.size() && ids[j] == ids[i]) ++j;
+          if (j - i >= least) f(ids[i], j - i);
+          i = j;
+        }
+      }
+
+
+    private:
+
+      /// membership of id in the posting of bit follows v
+
+      inline void refile(const std::uint32_t id, const word_t* v, const std::size_t bit) {
+        posting_t& p = lists[bit];
+        auto at = std::lower_bound(p.begin(), p.end(), id);
+        const bool listed = (at != p.end() && *at == id);
+        if ((v[bit / 64] >> (bit % 64)) & 1) {
+          if (!listed) p.insert(at, id);
+        } else if (listed) {
+          p.erase(at);
+        }
+      }
+
+      /// append id mostly at the end of a posting
+
+      static inline void add(posting_t& p, const std::uint32_t id) {
+        if (p.empty() || p.back() < id) p.push_back(id);
+        else p.insert(std::lower_bound(p.begin(), p.end(), id), id);
+      }
+
+      std::uint32_t filed;
+      postings_t lists;
+    };
+  }
+}
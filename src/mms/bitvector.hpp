@@ -1,5 +1,8 @@
 #pragma once
 #include "sdmconfig.h"
+#include "bitvector_kernels.hpp"
+#include <cstring>
+#include <vector>
 
 namespace sdm {
   namespace mms {
@@ -15,6 +18,8 @@ namespace sdm {
       :public base_t {
 
       static constexpr std::size_t dimensions =  n_elements * sizeof(element_t) * CHAR_BITS;
+
+      static_assert(sizeof(element_t) == sizeof(kernels::word_t), "kernels require 64 bit elements");
       
       ///////////////////
       /// constructors //
@@ -36,27 +41,23 @@ namespace sdm {
       }
 
       
+      /// raw words for the popcount kernels
+      inline const kernels::word_t* words() const {
+        return reinterpret_cast<const kernels::word_t*>(this->data());
+      }
+
+      
       ////////////////////////////////
       /// SDM bitvector arithmetic ///
       ////////////////////////////////
       
-      inline const std::size_t count() {
-        std::size_t count = 0;
-        #pragma unroll
-        #pragma clang loop vectorize(enable) interleave(enable)
-        for (unsigned i=0; i < n_elements; ++i) {
-          #if VELEMENT_64
-          count += __builtin_popcountll((*this)[i]);
-          #else
-          count += __builtin_popcount((*this)[i]);
-          #endif
-        }  
-        return count;
+      inline const std::size_t count() const {
+        return kernels::dispatch().count(words(), n_elements);
       }
 
       /// semantic density
       
-      inline const double density() {
+      inline const double density() const {
         return (double) count() / dimensions;
       }
         
@@ -67,52 +68,25 @@ namespace sdm {
       /// semantic distance is the Hamming distance
       
       inline const std::size_t distance(const bitvector& v) const {
-        std::size_t distance = 0;
-        #pragma unroll
-        #pragma clang loop vectorize(enable) interleave(enable)
-        for (unsigned i=0; i < n_elements; ++i) {
-          element_t r = (*this)[i] ^ v[i];
-          #ifdef VELEMENT_64
-          distance += __builtin_popcountll(r);
-          #else
-          distance += __builtin_popcount(r);
-          #endif
-        }
-        return distance;
+        return kernels::dispatch().distance(words(), v.words(), n_elements);
       }
     
       /// inner product is the commonality/overlap
       
       inline const std::size_t inner(const bitvector& v) const {
-        std::size_t count = 0;
-        #pragma unroll
-        #pragma clang loop vectorize(enable) interleave(enable)
-        for (unsigned i=0; i < n_elements; ++i) {
-          element_t r = (*this)[i] & v[i];
-          #ifdef VELEMENT_64
-          count += __builtin_popcountll(r);
-          #else
-          count += __builtin_popcount(r);
-          #endif
-        }
-        return count;
+        return kernels::dispatch().inner(words(), v.words(), n_elements);
       }
       
       /// semantic union
       
       inline const std::size_t countsum(const bitvector& v)  const {
-        std::size_t count = 0;
-        #pragma unroll
-        #pragma clang loop vectorize(enable) interleave(enable)
-        for (unsigned i=0; i < n_elements; ++i) {
-          element_t r = (*this)[i] | v[i];
-          #ifdef VELEMENT_64
-          count += __builtin_popcountll(r);
-          #else
-          count += __builtin_popcount(r);
-          #endif
-        }
-        return count;
+        return kernels::dispatch().countsum(words(), v.words(), n_elements);
+      }
+    
+      /// fused count of v, distance and inner product with v in one pass
+      
+      inline const kernels::metrics measure(const bitvector& v) const {
+        return kernels::dispatch().measure(words(), v.words(), n_elements);
       }
     
       /// semantic similarity
@@ -154,5 +128,91 @@ namespace sdm {
 
     };
     
+
+
+    ///
+    /// bitvector_view is a read only window on the words of a stored
+    /// vector e.g. in a mapped image -- it neither copies nor allocates
+    ///
+
+    template <typename element_t, std::size_t n_elements>
+
+    struct bitvector_view {
+
+      static constexpr std::size_t dimensions =  n_elements * sizeof(element_t) * CHAR_BITS;
+
+      static_assert(sizeof(element_t) == sizeof(kernels::word_t), "kernels require 64 bit elements");
+
+      explicit bitvector_view(const element_t* p) : _data(p) {}
+
+      /// container like accessors
+      
+      inline const element_t* data() const { return _data; }
+      inline const element_t* begin() const { return _data; }
+      inline const element_t* end() const { return _data + n_elements; }
+      inline std::size_t size() const { return n_elements; }
+      inline const element_t& operator[](std::size_t i) const { return _data[i]; }
+
+      /// raw words for the popcount kernels
+      inline const kernels::word_t* words() const {
+        return reinterpret_cast<const kernels::word_t*>(_data);
+      }
+
+      /// copy vector to destination
+      inline void copyto(element_t* dst) const {
+        std::memcpy(dst, _data, n_elements * sizeof(element_t));
+      }
+
+      ////////////////////////////////////////////////////
+      /// measurement against any vector exposing data()
+      ////////////////////////////////////////////////////
+
+      inline const std::size_t count() const {
+        return kernels::dispatch().count(words(), n_elements);
+      }
+
+      inline const double density() const {
+        return (double) count() / dimensions;
+      }
+
+      template <typename V>
+      inline const std::size_t distance(const V& v) const {
+        return kernels::dispatch().distance(words(), raw(v), n_elements);
+      }
+
+      template <typename V>
+      inline const std::size_t inner(const V& v) const {
+        return kernels::dispatch().inner(words(), raw(v), n_elements);
+      }
+
+      template <typename V>
+      inline const std::size_t countsum(const V& v) const {
+        return kernels::dispatch().countsum(words(), raw(v), n_elements);
+      }
+
+      template <typename V>
+      inline const kernels::metrics measure(const V& v) const {
+        return kernels::dispatch().measure(words(), raw(v), n_elements);
+      }
+
+      template <typename V>
+      inline const double similarity(const V& v) const {
+        return 1.0 - (double) distance(v)/dimensions;
+      }
+
+      template <typename V>
+      inline const double overlap(const V& v) const {
+        return (double) inner(v)/dimensions;
+      }
+
+    private:
+
+      template <typename V>
+      static inline const kernels::word_t* raw(const V& v) {
+        return reinterpret_cast<const kernels::word_t*>(v.data());
+      }
+
+      const element_t* _data;
+    };
   }
 }
@@ -0,0 +1,583 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SDM_X86_KERNELS 1
+#else
+#define SDM_X86_KERNELS 0
+#endif
+
+
+namespace sdm {
+  namespace mms {
+
+    ///
+    /// popcount kernels over arrays of 64 bit words -- a scalar version
+    /// that runs anywhere plus AVX2 and AVX-512 VPOPCNTDQ versions that
+    /// are compiled with per function target attributes so that one
+    /// binary can run on any x86_64 and pick the best at runtime.
+    ///
+
+    namespace kernels {
+
+      typedef std::uint64_t word_t;
+
+      /// fused measurements of a candidate v against a query q:
+      /// popcount(v), popcount(q^v) and popcount(q&v) from one read of v
+
+      struct metrics {
+        std::size_t count;
+        std::size_t distance;
+        std::size_t inner;
+      };
+
+      /// rows on each side of a many to many tile
+
+      static constexpr std::size_t tile_rows = 4;
+
+      /// table of kernel entry points for one instruction set
+
+      struct popcount_kernels {
+        const char* name;
+        std::size_t (*count)(const word_t*, const std::size_t);
+        std::size_t (*distance)(const word_t*, const word_t*, const std::size_t);
+        std::size_t (*inner)(const word_t*, const word_t*, const std::size_t);
+        std::size_t (*countsum)(const word_t*, const word_t*, const std::size_t);
+        metrics (*measure)(const word_t*, const word_t*, const std::size_t);
+        /// distance if at most bound or else some partial distance over
+        /// bound -- counted a block of words at a time so candidates that
+        /// cannot qualify are abandoned early
+        std::size_t (*distance_within)(const word_t*, const word_t*, const std::size_t, const std::size_t);
+        /// distances of tile_rows rows a[] to tile_rows rows b[] into
+        /// out[i * tile_rows + j] as by distance_within -- each word is
+        /// loaded once and the tile is abandoned once every pair is over
+        void (*distance_tile)(const word_t* const*, const word_t* const*, const std::size_t,
+                              const std::size_t, std::size_t*);
+      };
+
+      /// words counted between checks of the bound by the scalar kernels
+      /// and the popcnt tiles -- the vector kernels check once per block of
+      /// their main loops
+
+      static constexpr std::size_t abandon_words = 64;
+
+      /// binary operations applied word wise before counting
+
+      enum combine_op { first_op, xor_op, and_op, or_op };
+
+
+      ////////////
+      // scalar //
+      ////////////
+
+      namespace scalar {
+
+        template <int op>
+        inline word_t combine(const word_t a, const word_t b) {
+          switch (op) {
+          case xor_op: return a ^ b;
+          case and_op: return a & b;
+          case or_op:  return a | b;
+          default:     return a;
+          }
+        }
+
+        template <int op>
+        inline std::size_t reduce(const word_t* a, const word_t* b, const std::size_t n) {
+          std::size_t count = 0;
+          for (std::size_t i = 0; i < n; ++i)
+            count += __builtin_popcountll(combine<op>(a[i], b[i]));
+          return count;
+        }
+
+        inline std::size_t count(const word_t* a, const std::size_t n) {
+          return reduce<first_op>(a, a, n);
+        }
+
+        inline std::size_t distance(const word_t* a, const word_t* b, const std::size_t n) {
+          return reduce<xor_op>(a, b, n);
+        }
+
+        inline std::size_t inner(const word_t* a, const word_t* b, const std::size_t n) {
+          return reduce<and_op>(a, b, n);
+        }
+
+        inline std::size_t countsum(const word_t* a, const word_t* b, const std::size_t n) {
+          return reduce<or_op>(a, b, n);
+        }
+
+        inline metrics measure(const word_t* q, const word_t* v, const std::size_t n) {
+          metrics m = {0, 0, 0};
+          for (std::size_t i = 0; i < n; ++i) {
+            const word_t w = v[i];
+            m.count += __builtin_popcountll(w);
+            m.distance += __builtin_popcountll(q[i] ^ w);
+            m.inner += __builtin_popcountll(q[i] & w);
+          }
+          return m;
+        }
+
+        inline std::size_t distance_within(const word_t* a, const word_t* b,
+                                           const std::size_t n, const std::size_t bound) {
+          std::size_t d = 0, i = 0;
+          for (; i + abandon_words <= n; i += abandon_words) {
+            for (std::size_t w = i; w < i + abandon_words; ++w) d += __builtin_popcountll(a[w] ^ b[w]);
+            if (d > bound) return d;
+          }
+          return d + reduce<xor_op>(a+i, b+i, n-i);
+        }
+
+        inline void distance_tile(const word_t* const* a, const word_t* const* b,
+                                  const std::size_t n, const std::size_t bound, std::size_t* out) {
+          std::size_t acc[tile_rows * tile_rows] = {0};
+          for (std::size_t w = 0; w < n;) {
+            const std::size_t e = std::min(w + abandon_words, n);
+            for (; w < e; ++w)
+              for (std::size_t i = 0; i < tile_rows; ++i) {
+                const word_t x = a[i][w];
+                for (std::size_t j = 0; j < tile_rows; ++j)
+                  acc[i * tile_rows + j] += __builtin_popcountll(x ^ b[j][w]);
+              }
+            if (*std::min_element(acc, acc + tile_rows * tile_rows) > bound) break;
+          }
+          std::copy(acc, acc + tile_rows * tile_rows, out);
+        }
+      }
+
+      inline const popcount_kernels& scalar_kernels() {
+        static const popcount_kernels k = {
+          "scalar", &scalar::count, &scalar::distance, &scalar::inner, &scalar::countsum,
+          &scalar::measure, &scalar::distance_within, &scalar::distance_tile
+        };
+        return k;
+      }
+
+
+#if SDM_X86_KERNELS
+
+      //////////////////////////////////////////////////////
+      // AVX2 -- Harley-Seal carry save adder over 16 x 256
+      // bit blocks with a nibble lookup popcount (Mula et al.)
+      //////////////////////////////////////////////////////
+
+      namespace avx2 {
+
+        template <int op>
+        __attribute__((target("avx2")))
+        inline __m256i combine(const word_t* a, const word_t* b) {
+          __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+          if (op == first_op) return x;
+          __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+          switch (op) {
+          case xor_op: return _mm256_xor_si256(x, y);
+          case and_op: return _mm256_and_si256(x, y);
+          default:     return _mm256_or_si256(x, y);
+          }
+        }
+
+        /// per byte popcount of a 256 bit register
+
+        __attribute__((target("avx2")))
+        inline __m256i popcount_bytes(const __m256i v) {
+          const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                  0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+          const __m256i low_mask = _mm256_set1_epi8(0x0f);
+          __m256i lo = _mm256_and_si256(v, low_mask);
+          __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+          return _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+        }
+
+        /// per 64 bit lane popcount of a 256 bit register
+
+        __attribute__((target("avx2")))
+        inline __m256i popcount(const __m256i v) {
+          return _mm256_sad_epu8(popcount_bytes(v), _mm256_setzero_si256());
+        }
+
+        /// carry save adder
+
+        __attribute__((target("avx2")))
+        inline void csa(__m256i& h, __m256i& l, const __m256i a, const __m256i b, const __m256i c) {
+          const __m256i u = _mm256_xor_si256(a, b);
+          h = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+          l = _mm256_xor_si256(u, c);
+        }
+
+        __attribute__((target("avx2")))
+        inline std::size_t horizontal_sum(const __m256i v) {
+          return _mm256_extract_epi64(v, 0) + _mm256_extract_epi64(v, 1)
+            + _mm256_extract_epi64(v, 2) + _mm256_extract_epi64(v, 3);
+        }
+
+        template <int op>
+        __attribute__((target("avx2")))
+        inline std::size_t reduce(const word_t* a, const word_t* b, const std::size_t n) {
+
+          __m256i total = _mm256_setzero_si256();
+          __m256i ones = _mm256_setzero_si256();
+          __m256i twos = _mm256_setzero_si256();
+          __m256i fours = _mm256_setzero_si256();
+          __m256i eights = _mm256_setzero_si256();
+          __m256i sixteens, twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+
+          // 16 registers of 4 words per iteration
+          std::size_t i = 0;
+          for (; i + 64 <= n; i += 64) {
+            csa(twos_a, ones, ones, combine<op>(a+i, b+i), combine<op>(a+i+4, b+i+4));
+            csa(twos_b, ones, ones, combine<op>(a+i+8, b+i+8), combine<op>(a+i+12, b+i+12));
+            csa(fours_a, twos, twos, twos_a, twos_b);
+            csa(twos_a, ones, ones, combine<op>(a+i+16, b+i+16), combine<op>(a+i+20, b+i+20));
+            csa(twos_b, ones, ones, combine<op>(a+i+24, b+i+24), combine<op>(a+i+28, b+i+28));
+            csa(fours_b, twos, twos, twos_a, twos_b);
+            csa(eights_a, fours, fours, fours_a, fours_b);
+            csa(twos_a, ones, ones, combine<op>(a+i+32, b+i+32), combine<op>(a+i+36, b+i+36));
+            csa(twos_b, ones, ones, combine<op>(a+i+40, b+i+40), combine<op>(a+i+44, b+i+44));
+            csa(fours_a, twos, twos, twos_a, twos_b);
+            csa(twos_a, ones, ones, combine<op>(a+i+48, b+i+48), combine<op>(a+i+52, b+i+52));
+            csa(twos_b, ones, ones, combine<op>(a+i+56, b+i+56), combine<op>(a+i+60, b+i+60));
+            csa(fours_b, twos, twos, twos_a, twos_b);
+            csa(eights_b, fours, fours, fours_a, fours_b);
+            csa(sixteens, eights, eights, eights_a, eights_b);
+            total = _mm256_add_epi64(total, popcount(sixteens));
+          }
+
+          // weight the partial sums
+          total = _mm256_slli_epi64(total, 4);
+          total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount(eights), 3));
+          total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount(fours), 2));
+          total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount(twos), 1));
+          total = _mm256_add_epi64(total, popcount(ones));
+
+          // remaining whole registers
+          for (; i + 4 <= n; i += 4)
+            total = _mm256_add_epi64(total, popcount(combine<op>(a+i, b+i)));
+
+          // and any remaining words
+          return horizontal_sum(total) + scalar::reduce<op>(a+i, b+i, n-i);
+        }
+
+        inline std::size_t count(const word_t* a, const std::size_t n) {
+          return reduce<first_op>(a, a, n);
+        }
+
+        inline std::size_t distance(const word_t* a, const word_t* b, const std::size_t n) {
+          return reduce<xor_op>(a, b, n);
+        }
+
+        inline std::size_t inner(const word_t* a, const word_t* b, const std::size_t n) {
+          return reduce<and_op>(a, b, n);
+        }
+
+        inline std::size_t countsum(const word_t* a, const word_t* b, const std::size_t n) {
+          return reduce<or_op>(a, b, n);
+        }
+
+        /// fused measure -- byte counters are widened every 8 registers
+        /// (at most 64 per byte) so each candidate register is loaded once
+
+        __attribute__((target("avx2")))
+        inline metrics measure(const word_t* q, const word_t* v, const std::size_t n) {
+          const __m256i zero = _mm256_setzero_si256();
+          __m256i count = zero, distance = zero, inner = zero;
+          std::size_t i = 0;
+          while (i + 4 <= n) {
+            __m256i c8 = zero, d8 = zero, i8 = zero;
+            for (unsigned r = 0; r < 8 && i + 4 <= n; ++r, i += 4) {
+              __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q+i));
+              __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v+i));
+              c8 = _mm256_add_epi8(c8, popcount_bytes(y));
+              d8 = _mm256_add_epi8(d8, popcount_bytes(_mm256_xor_si256(x, y)));
+              i8 = _mm256_add_epi8(i8, popcount_bytes(_mm256_and_si256(x, y)));
+            }
+            count = _mm256_add_epi64(count, _mm256_sad_epu8(c8, zero));
+            distance = _mm256_add_epi64(distance, _mm256_sad_epu8(d8, zero));
+            inner = _mm256_add_epi64(inner, _mm256_sad_epu8(i8, zero));
+          }
+          metrics tail = scalar::measure(q+i, v+i, n-i);
+          metrics m = {horizontal_sum(count) + tail.count,
+                       horizontal_sum(distance) + tail.distance,
+                       horizontal_sum(inner) + tail.inner};
+          return m;
+        }
+
+        /// count so far from harley-seal partial sums
+
+        __attribute__((target("avx2")))
+        inline __m256i weigh(const __m256i sixteens, const __m256i eights, const __m256i fours,
+                             const __m256i twos, const __m256i ones) {
+          __m256i t = _mm256_slli_epi64(sixteens, 4);
+          t = _mm256_add_epi64(t, _mm256_slli_epi64(popcount(eights), 3));
+          t = _mm256_add_epi64(t, _mm256_slli_epi64(popcount(fours), 2));
+          t = _mm256_add_epi64(t, _mm256_slli_epi64(popcount(twos), 1));
+          return _mm256_add_epi64(t, popcount(ones));
+        }
+
+        /// harley-seal as in reduce checking the bound after each block
+        /// of 16 registers (64 words) from the weighted partial counts
+
+        __attribute__((target("avx2")))
+        inline std::size_t distance_within(const word_t* a, const word_t* b,
+                                           const std::size_t n, const std::size_t bound) {
+          __m256i total = _mm256_setzero_si256();
+          __m256i ones = _mm256_setzero_si256();
+          __m256i twos = _mm256_setzero_si256();
+          __m256i fours = _mm256_setzero_si256();
+          __m256i eights = _mm256_setzero_si256();
+          __m256i sixteens, twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+
+          std::size_t i = 0;
+          for (; i + 64 <= n; i += 64) {
+            csa(twos_a, ones, ones, combine<xor_op>(a+i, b+i), combine<xor_op>(a+i+4, b+i+4));
+            csa(twos_b, ones, ones, combine<xor_op>(a+i+8, b+i+8), combine<xor_op>(a+i+12, b+i+12));
+            csa(fours_a, twos, twos, twos_a, twos_b);
+            csa(twos_a, ones, ones, combine<xor_op>(a+i+16, b+i+16), combine<xor_op>(a+i+20, b+i+20));
+            csa(twos_b, ones, ones, combine<xor_op>(a+i+24, b+i+24), combine<xor_op>(a+i+28, b+i+28));
+            csa(fours_b, twos, twos, twos_a, twos_b);
+            csa(eights_a, fours, fours, fours_a, fours_b);
+            csa(twos_a, ones, ones, combine<xor_op>(a+i+32, b+i+32), combine<xor_op>(a+i+36, b+i+36));
+            csa(twos_b, ones, ones, combine<xor_op>(a+i+40, b+i+40), combine<xor_op>(a+i+44, b+i+44));
+            csa(fours_a, twos, twos, twos_a, twos_b);
+            csa(twos_a, ones, ones, combine<xor_op>(a+i+48, b+i+48), combine<xor_op>(a+i+52, b+i+52));
+            csa(twos_b, ones, ones, combine<xor_op>(a+i+56, b+i+56), combine<xor_op>(a+i+60, b+i+60));
+            csa(fours_b, twos, twos, twos_a, twos_b);
+            csa(eights_b, fours, fours, fours_a, fours_b);
+            csa(sixteens, eights, eights, eights_a, eights_b);
+            total = _mm256_add_epi64(total, popcount(sixteens));
+
+            const std::size_t d = horizontal_sum(weigh(total, eights, fours, twos, ones));
+            if (d > bound) return d;
+          }
+
+          total = weigh(total, eights, fours, twos, ones);
+          for (; i + 4 <= n; i += 4)
+            total = _mm256_add_epi64(total, popcount(combine<xor_op>(a+i, b+i)));
+          return horizontal_sum(total) + scalar::reduce<xor_op>(a+i, b+i, n-i);
+        }
+
+        /// sixteen lookup counters do not fit the sixteen ymm registers
+        /// with the operands so the tile uses the scalar popcnt unit
+
+        __attribute__((target("popcnt")))
+        inline void distance_tile(const word_t* const* a, const word_t* const* b,
+                                  const std::size_t n, const std::size_t bound, std::size_t* out) {
+          std::size_t acc[tile_rows * tile_rows] = {0};
+          for (std::size_t w = 0; w < n;) {
+            const std::size_t e = std::min(w + abandon_words, n);
+            for (; w < e; ++w)
+              for (std::size_t i = 0; i < tile_rows; ++i) {
+                const word_t x = a[i][w];
+                for (std::size_t j = 0; j < tile_rows; ++j)
+                  acc[i * tile_rows + j] += __builtin_popcountll(x ^ b[j][w]);
+              }
+            if (*std::min_element(acc, acc + tile_rows * tile_rows) > bound) break;
+          }
+          std::copy(acc, acc + tile_rows * tile_rows, out);
+        }
+      }
+
+
+      /////////////////////////////
+      // AVX-512 with VPOPCNTDQ  //
+      /////////////////////////////
+
+      namespace avx512 {
+
+        template <int op>
+        __attribute__((target("avx512f")))
+        inline __m512i combine(const word_t* a, const word_t* b) {
+          __m512i x = _mm512_loadu_si512(a);
+          if (op == first_op) return x;
+          __m512i y = _mm512_loadu_si512(b);
+          switch (op) {
+          case xor_op: return _mm512_xor_si512(x, y);
+          case and_op: return _mm512_and_si512(x, y);
+          default:     return _mm512_or_si512(x, y);
+          }
+        }
+
+        template <int op>
+        __attribute__((target("avx512f,avx512vpopcntdq")))
+        inline std::size_t reduce(const word_t* a, const word_t* b, const std::size_t n) {
+          // two accumulators to keep the popcount units busy
+          __m512i acc0 = _mm512_setzero_si512();
+          __m512i acc1 = _mm512_setzero_si512();
+          std::size_t i = 0;
+          for (; i + 16 <= n; i += 16) {
+            acc0 = _mm512_add_epi64(acc0, _mm512_popcnt_epi64(combine<op>(a+i, b+i)));
+            acc1 = _mm512_add_epi64(acc1, _mm512_popcnt_epi64(combine<op>(a+i+8, b+i+8)));
+          }
+          for (; i + 8 <= n; i += 8)
+            acc0 = _mm512_add_epi64(acc0, _mm512_popcnt_epi64(combine<op>(a+i, b+i)));
+
+          return _mm512_reduce_add_epi64(_mm512_add_epi64(acc0, acc1))
+            + scalar::reduce<op>(a+i, b+i, n-i);
+        }
+
+        inline std::size_t count(const word_t* a, const std::size_t n) {
+          return reduce<first_op>(a, a, n);
+        }
+
+        inline std::size_t distance(const word_t* a, const word_t* b, const std::size_t n) {
+          return reduce<xor_op>(a, b, n);
+        }
+
+        inline std::size_t inner(const word_t* a, const word_t* b, const std::size_t n) {
+          return reduce<and_op>(a, b, n);
+        }
+
+        inline std::size_t countsum(const word_t* a, const word_t* b, const std::size_t n) {
+          return reduce<or_op>(a, b, n);
+        }
+
+        __attribute__((target("avx512f,avx512vpopcntdq")))
+        inline metrics measure(const word_t* q, const word_t* v, const std::size_t n) {
+          __m512i count = _mm512_setzero_si512();
+          __m512i distance = _mm512_setzero_si512();
+          __m512i inner = _mm512_setzero_si512();
+          std::size_t i = 0;
+          for (; i + 8 <= n; i += 8) {
+            __m512i x = _mm512_loadu_si512(q+i);
+            __m512i y = _mm512_loadu_si512(v+i);
+            count = _mm512_add_epi64(count, _mm512_popcnt_epi64(y));
+            distance = _mm512_add_epi64(distance, _mm512_popcnt_epi64(_mm512_xor_si512(x, y)));
+            inner = _mm512_add_epi64(inner, _mm512_popcnt_epi64(_mm512_and_si512(x, y)));
+          }
+          metrics tail = scalar::measure(q+i, v+i, n-i);
+          metrics m = {(std::size_t) _mm512_reduce_add_epi64(count) + tail.count,
+                       (std::size_t) _mm512_reduce_add_epi64(distance) + tail.distance,
+                       (std::size_t) _mm512_reduce_add_epi64(inner) + tail.inner};
+          return m;
+        }
+
+        /// a reduction per register costs about as much as the counting
+        /// so the bound is checked every 4 registers (32 words) with two
+        /// accumulators as in reduce
+
+        __attribute__((target("avx512f,avx512vpopcntdq")))
+        inline std::size_t distance_within(const word_t* a, const word_t* b,
+                                           const std::size_t n, const std::size_t bound) {
+          __m512i acc0 = _mm512_setzero_si512();
+          __m512i acc1 = _mm512_setzero_si512();
+          std::size_t i = 0;
+          for (; i + 32 <= n; i += 32) {
+            acc0 = _mm512_add_epi64(acc0, _mm512_popcnt_epi64(combine<xor_op>(a+i, b+i)));
+            acc1 = _mm512_add_epi64(acc1, _mm512_popcnt_epi64(combine<xor_op>(a+i+8, b+i+8)));
+            acc0 = _mm512_add_epi64(acc0, _mm512_popcnt_epi64(combine<xor_op>(a+i+16, b+i+16)));
+            acc1 = _mm512_add_epi64(acc1, _mm512_popcnt_epi64(combine<xor_op>(a+i+24, b+i+24)));
+            const std::size_t d = _mm512_reduce_add_epi64(_mm512_add_epi64(acc0, acc1));
+            if (d > bound) return d;
+          }
+          for (; i + 8 <= n; i += 8)
+            acc0 = _mm512_add_epi64(acc0, _mm512_popcnt_epi64(combine<xor_op>(a+i, b+i)));
+
+          return _mm512_reduce_add_epi64(_mm512_add_epi64(acc0, acc1))
+            + scalar::reduce<xor_op>(a+i, b+i, n-i);
+        }
+
+        /// 4 x 4 register block: 8 operand and 16 accumulator registers.
+        /// Sixteen reductions cost about as much as a block of counting
+        /// so the bound is only checked every 8 blocks (64 words)
+
+        __attribute__((target("avx512f,avx512vpopcntdq")))
+        inline void distance_tile(const word_t* const* a, const word_t* const* b,
+                                  const std::size_t n, const std::size_t bound, std::size_t* out) {
+          static_assert(tile_rows == 4, "register block is 4 x 4");
+          __m512i acc[16];
+          for (unsigned t = 0; t < 16; ++t) acc[t] = _mm512_setzero_si512();
+
+          std::size_t w = 0;
+          bool over = false;
+          while (w + 8 <= n && !over) {
+            for (const std::size_t e = w + 64; w + 8 <= n && w < e; w += 8) {
+              const __m512i a0 = _mm512_loadu_si512(a[0]+w), a1 = _mm512_loadu_si512(a[1]+w);
+              const __m512i a2 = _mm512_loadu_si512(a[2]+w), a3 = _mm512_loadu_si512(a[3]+w);
+              for (unsigned j = 0; j < 4; ++j) {
+                const __m512i y = _mm512_loadu_si512(b[j]+w);
+                acc[0 + j] = _mm512_add_epi64(acc[0 + j], _mm512_popcnt_epi64(_mm512_xor_si512(a0, y)));
+                acc[4 + j] = _mm512_add_epi64(acc[4 + j], _mm512_popcnt_epi64(_mm512_xor_si512(a1, y)));
+                acc[8 + j] = _mm512_add_epi64(acc[8 + j], _mm512_popcnt_epi64(_mm512_xor_si512(a2, y)));
+                acc[12 + j] = _mm512_add_epi64(acc[12 + j], _mm512_popcnt_epi64(_mm512_xor_si512(a3, y)));
+              }
+            }
+            over = true;
+            for (unsigned t = 0; t < 16; ++t) {
+              out[t] = _mm512_reduce_add_epi64(acc[t]);
+              over = over && out[t] > bound;
+            }
+          }
+          if (over) return;
+
+          for (unsigned i = 0; i < 4; ++i)
+            for (unsigned j = 0; j < 4; ++j)
+              out[i * 4 + j] = _mm512_reduce_add_epi64(acc[i * 4 + j])
+                + scalar::reduce<xor_op>(a[i]+w, b[j]+w, n-w);
+        }
+      }
+
+      inline const popcount_kernels& avx2_kernels() {
+        static const popcount_kernels k = {
+          "avx2", &avx2::count, &avx2::distance, &avx2::inner, &avx2::countsum,
+          &avx2::measure, &avx2::distance_within, &avx2::distance_tile
+        };
+        return k;
+      }
+
+      inline const popcount_kernels& avx512_kernels() {
+        static const popcount_kernels k = {
+          "avx512", &avx512::count, &avx512::distance, &avx512::inner, &avx512::countsum,
+          &avx512::measure, &avx512::distance_within, &avx512::distance_tile
+        };
+        return k;
+      }
+
+#endif // SDM_X86_KERNELS
+
+
+      //////////////////////////
+      // cpu feature dispatch //
+      //////////////////////////
+
+      /// all kernels the running cpu can execute, best last
+
+      inline std::vector<const popcount_kernels*> supported() {
+        std::vector<const popcount_kernels*> ks;
+        ks.push_back(&scalar_kernels());
+#if SDM_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+          ks.push_back(&avx2_kernels());
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq"))
+          ks.push_back(&avx512_kernels());
+#endif
+        return ks;
+      }
+
+      /// pick the best supported kernels -- SDM_KERNELS=scalar|avx2|avx512
+      /// in the environment pins a (supported) choice
+
+      inline const popcount_kernels& select() {
+        std::vector<const popcount_kernels*> ks = supported();
+        const char* wanted = std::getenv("SDM_KERNELS");
+        if (wanted) for (auto k: ks) {
+            if (std::strcmp(k->name, wanted) == 0) return *k;
+          }
+        return *ks.back();
+      }
+
+      /// kernels chosen once on first use
+
+      inline const popcount_kernels& dispatch() {
+        static const popcount_kernels& k = select();
+        return k;
+      }
+
+    }
+  }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <boost/interprocess/allocators/allocator.hpp>
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/tuple/tuple.hpp>
+
+
+namespace sdm {
+
+  namespace mms {
+
+    namespace bip = boost::interprocess;
+
+    //////////////////////////////////////////////////////////////////////
+    /// bucket_index - mapped table of symbol ids filed under a key in
+    ///                each of several tables -- the storage shared by
+    ///                the hashing search indexes of a space which lives
+    ///                in the image next to the symbol table
+    //////////////////////////////////////////////////////////////////////
+
+    struct bucket_entry {
+      std::uint64_t key;
+      std::uint32_t id;
+      std::uint32_t table;
+    };
+
+    // index tags
+    struct by_bucket {};
+    struct by_symbol {};
+
+    template <typename segment_manager_t>
+
+    class bucket_index final {
+
+      typedef boost::multi_index::multi_index_container<
+        bucket_entry,
+        boost::multi_index::indexed_by<
+          boost::multi_index::hashed_non_unique<
+            boost::multi_index::tag<by_bucket>,
+            boost::multi_index::composite_key<
+              bucket_entry,
+              boost::multi_index::member<bucket_entry, std::uint32_t, &bucket_entry::table>,
+              boost::multi_index::member<bucket_entry, std::uint64_t, &bucket_entry::key>>>,
+          boost::multi_index::hashed_non_unique<
+            boost::multi_index::tag<by_symbol>,
+            boost::multi_index::member<bucket_entry, std::uint32_t, &bucket_entry::id>>
+          >,
+        bip::allocator<bucket_entry, segment_manager_t>
+        > entries_t;
+
+    public:
+
+      typedef bip::allocator<void, segment_manager_t> void_allocator_t;
+
+      bucket_index(const unsigned n, const void_allocator_t& a)
+        : n_tables(n), entries(a) {}
+
+
+      /// number of tables each symbol is filed in
+
+      inline unsigned tables() const { return n_tables; }
+
+      /// number of entries over all tables
+
+      inline std::size_t size() const { return entries.size(); }
+
+
+      /// file symbol id under keys[t] in each table t -- only the keys
+      /// that have changed since last filed are moved
+
+      void file(const std::uint32_t id, const std::uint64_t* keys) {
+        auto& symbols = entries.template get<by_symbol>();
+        auto range = symbols.equal_range(id);
+
+        if (range.first == range.second) {
+          for (std::uint32_t t = 0; t < n_tables; ++t)
+            entries.insert(bucket_entry{keys[t], id, t});
+
+        } else {
+          for (auto it = range.first; it != range.second; ++it) {
+            const std::uint64_t key = keys[it->table];
+            if (it->key != key)
+              symbols.modify(it, [key](bucket_entry& e) { e.key = key; });
+          }
+        }
+      }
+
+
+      /// apply f to each symbol id filed under key in table -- answers the
+      /// number of ids visited
+
+      template <typename F>
+      inline std::size_t bucket(const std::uint32_t table, const std::uint64_t key, F f) const {
+        auto range = entries.template get<by_bucket>().equal_range(boost::make_tuple(table, key));
+        std::size_t n = 0;
+        for (auto it = range.first; it != range.second; ++it, ++n) f(it->id);
+        return n;
+      }
+
+
+    private:
+
+      const unsigned n_tables;
+      entries_t entries;
+    };
+  }
+}
@@ -2,9 +2,12 @@
 
 #pragma once
 
+#include <cmath>
 #include <boost/interprocess/allocators/allocator.hpp>
 #include <boost/interprocess/containers/vector.hpp>
 
+#include "sdmconfig.h"
+
 namespace sdm {
   
   namespace mms {
@@ -26,6 +29,116 @@ namespace sdm {
                        const void_allocator_t& a) : container_t(fs.begin(), fs.begin()+s, a) {}
       
     };
+
+
+    /// read only view of the stored elemental indices of a symbol
+    
+    template <typename index_t>
+    
+    struct elemental_view {
+
+      elemental_view(const index_t* p, const std::size_t n) : _data(p), _size(n) {}
+      
+      inline const index_t* data() const { return _data; }
+      inline const index_t* begin() const { return _data; }
+      inline const index_t* end() const { return _data + _size; }
+      inline std::size_t size() const { return _size; }
+      inline const index_t& operator[](std::size_t i) const { return _data[i]; }
+
+    private:
+      const index_t* _data;
+      std::size_t _size;
+    };
+
+    
+    /// superpose a (rotated) elemental basis onto the words of a vector:
+    /// the first floor(p * n) indices are set and the remainder cleared
+    /// to dither the learning rate
+    
+    template <typename element_t, typename index_t>
+    inline void superpose_basis(element_t* words,
+                                const unsigned dimensions,
+                                const index_t* basis,
+                                const std::size_t n,
+                                const float p,
+                                const int rotations) {
+      
+      const unsigned h = floor(p * n);
+      
+      // set h
+      for (auto it = basis; it < basis + h; ++it) {
+        unsigned r = (*it + rotations) % dimensions;
+        unsigned i = r / (sizeof(element_t) * CHAR_BITS);
+        unsigned b = r % (sizeof(element_t) * CHAR_BITS);
+        words[i] |= (ONE << b);
+      }
+      
+      // clear remainder
+      for (auto it = basis + h; it < basis + n; ++it) {
+        unsigned r = (*it + rotations) % dimensions;
+        unsigned i = r / (sizeof(element_t) * CHAR_BITS);
+        unsigned b = r % (sizeof(element_t) * CHAR_BITS);
+        words[i] &= ~(ONE << b);
+      }
+    }
+
+
+    /// fold a (rotated) elemental basis into set and clear masks as
+    /// superpose_basis would apply it: bases folded in turn override
+    /// earlier ones bit by bit so that applying the masks once gives
+    /// the same vector as superposing each of them in order
+
+    template <typename element_t, typename index_t>
+    inline void mask_basis(element_t* set,
+                           element_t* clear,
+                           const unsigned dimensions,
+                           const index_t* basis,
+                           const std::size_t n,
+                           const float p,
+                           const int rotations) {
+
+      const unsigned h = floor(p * n);
+
+      for (auto it = basis; it < basis + n; ++it) {
+        unsigned r = (*it + rotations) % dimensions;
+        unsigned i = r / (sizeof(element_t) * CHAR_BITS);
+        element_t b = ONE << (r % (sizeof(element_t) * CHAR_BITS));
+        if (it < basis + h) {
+          set[i] |= b;
+          clear[i] &= ~b;
+        } else {
+          clear[i] |= b;
+          set[i] &= ~b;
+        }
+      }
+    }
+
+
+    /// apply set and clear masks to the words of a vector in one pass
+
+    template <typename element_t>
+    inline void superpose_masks(element_t* words,
+                                const element_t* set,
+                                const element_t* clear,
+                                const std::size_t n) {
+      for (std::size_t i = 0; i < n; ++i) words[i] = (words[i] & ~clear[i]) | set[i];
+    }
+
+
+    /// fold the masks of later bases (set2, clear2) into those of
+    /// earlier ones so that applying the result is applying both in turn
+
+    template <typename element_t>
+    inline void compose_masks(element_t* set,
+                              element_t* clear,
+                              const element_t* set2,
+                              const element_t* clear2,
+                              const std::size_t n) {
+      for (std::size_t i = 0; i < n; ++i) {
+        set[i] = (set[i] & ~clear2[i]) | set2[i];
+        clear[i] = (clear[i] & ~set2[i]) | clear2[i];
+      }
+    }
   }
 }
 
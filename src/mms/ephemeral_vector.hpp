@@ -18,6 +18,8 @@ namespace sdm {
     struct ephemeral_vector :public base_t {
 
       static constexpr std::size_t dimensions =  n_elements * sizeof(element_t) * CHAR_BITS;
+
+      static_assert(sizeof(element_t) == sizeof(kernels::word_t), "kernels require 64 bit elements");
       
       /// constructors
       ephemeral_vector() : base_t() {
@@ -32,6 +34,11 @@ namespace sdm {
           this->push_back(other[i]);
       }
 
+      /// raw words for the popcount kernels
+      inline const kernels::word_t* words() const {
+        return reinterpret_cast<const kernels::word_t*>(this->data());
+      }
+
       /////////////////////////////////////////////
       /// binary operations on wrapped vector type
       /////////////////////////////////////////////
@@ -39,52 +46,33 @@ namespace sdm {
       /// semantic distance is the Hamming distance
       
       inline const std::size_t distance(const W& v) const {
-        std::size_t distance = 0;
-        #pragma unroll
-        #pragma clang loop vectorize(enable) interleave(enable)
-        for (unsigned i=0; i < n_elements; ++i) {
-          element_t r = (*this)[i] ^ v[i];
-          #ifdef VELEMENT_64
-          distance += __builtin_popcountll(r);
-          #else
-          distance += __builtin_popcount(r);
-          #endif
-        }
-        return distance;
+        return kernels::dispatch().distance(words(),
+                                           reinterpret_cast<const kernels::word_t*>(v.data()),
+                                           n_elements);
       }
     
       /// inner product is the commonality/overlap
       
       inline const std::size_t inner(const W& v) const {
-        std::size_t count = 0;
-        #pragma unroll
-        #pragma clang loop vectorize(enable) interleave(enable)
-        for (unsigned i=0; i < n_elements; ++i) {
-          element_t r = (*this)[i] & v[i];
-          #ifdef VELEMENT_64
-          count += __builtin_popcountll(r);
-          #else
-          count += __builtin_popcount(r);
-          #endif
-        }
-        return count;
+        return kernels::dispatch().inner(words(),
+                                           reinterpret_cast<const kernels::word_t*>(v.data()),
+                                           n_elements);
       }
       
       /// semantic union
       
       inline const std::size_t countsum(const W& v) const {
-        std::size_t count = 0;
-        #pragma unroll
-        #pragma clang loop vectorize(enable) interleave(enable)
-        for (unsigned i=0; i < n_elements; ++i) {
-          element_t r = (*this)[i] | v[i];
-          #ifdef VELEMENT_64
-          count += __builtin_popcountll(r);
-          #else
-          count += __builtin_popcount(r);
-          #endif
-        }
-        return count;
+        return kernels::dispatch().countsum(words(),
+                                           reinterpret_cast<const kernels::word_t*>(v.data()),
+                                           n_elements);
+      }
+    
+      /// fused count of v, distance and inner product with v in one pass
+      
+      inline const kernels::metrics measure(const W& v) const {
+        return kernels::dispatch().measure(words(),
+                                           reinterpret_cast<const kernels::word_t*>(v.data()),
+                                           n_elements);
       }
     
       /// semantic similarity
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstdint>
+
+#include "sdmconfig.h"
+#include "../rtl/sdmtypes.h"
+
+#include "bitvector.hpp"
+#include "elemental_vector.hpp"
+
+
+namespace sdm {
+
+  namespace mms {
+
+    //////////////////////////////////////////////////////////////////////
+    /// flat_symbol - symbol record with the semantic vector and elemental
+    ///               fingerprint held inline, saving two allocations and
+    ///               pointer hops per symbol; the vector words start on a
+    ///               cache line so scans get aligned SIMD loads
+    //////////////////////////////////////////////////////////////////////
+
+    template <typename segment_manager_t, typename shared_string_t, typename allocator_t>
+
+    struct flat_symbol final {
+
+      typedef SDM_VECTOR_ELEMENT_TYPE element_t;
+
+      static constexpr unsigned n_elements = SDM_VECTOR_ELEMS;
+
+      static constexpr unsigned dimensions =  n_elements * sizeof(element_t) * CHAR_BITS;
+
+      // elemental bits
+
+      static constexpr unsigned elemental_bits = SDM_VECTOR_BASIS_SIZE;
+
+      // views of the inline state
+
+      typedef bitvector_view<SDM_VECTOR_ELEMENT_TYPE,
+                             SDM_VECTOR_ELEMS> vector_view_t;
+
+      typedef elemental_view<unsigned> basis_view_t;
+
+      // image layout tag -- see symbol_space
+
+      static constexpr unsigned layout = SDM_LAYOUT_FLAT;
+
+      static constexpr std::size_t line_size = 64;
+
+    private:
+
+      // the segment allocator only guarantees 16 byte alignment so the
+      // vector starts at the first cache line boundary within _words:
+      // records never move in the image and mappings are page aligned
+      // so the offset is the same in every mapping
+
+      element_t _words[n_elements + line_size / sizeof(element_t)];
+      unsigned _basis[elemental_bits];
+
+      inline element_t* words() {
+        return reinterpret_cast<element_t*>((reinterpret_cast<std::uintptr_t>(_words) + line_size - 1)
+                                            & ~std::uintptr_t(line_size - 1));
+      }
+
+      inline const element_t* words() const {
+        return const_cast<flat_symbol*>(this)->words();
+      }
+
+    public:
+
+      // state
+
+      shared_string_t _name;
+      sdm_prob_t _dither;
+
+      /// symbol constructor with immuatable fingerprint
+
+      flat_symbol(const char* s,
+                  const std::vector<unsigned>& f,
+                  const allocator_t& a,
+                  const sdm_prob_t p)
+        : _name(s, a),
+          _dither(p) {
+        std::fill(words(), words() + n_elements, 0);
+        std::copy(f.begin(), f.begin() + elemental_bits, _basis);
+      }
+
+      /// copies realign the vector e.g. from a temporary into an index node
+
+      flat_symbol(const flat_symbol& s)
+        : _name(s._name),
+          _dither(s._dither) {
+        std::copy(s.words(), s.words() + n_elements, words());
+        std::copy(s._basis, s._basis + elemental_bits, _basis);
+      }
+
+      flat_symbol& operator=(const flat_symbol& s) {
+        _name = s._name;
+        _dither = s._dither;
+        std::copy(s.words(), s.words() + n_elements, words());
+        std::copy(s._basis, s._basis + elemental_bits, _basis);
+        return *this;
+      }
+
+
+      /// copy of name just a lot easier
+      inline std::string name(void) const {
+        return std::string(_name.begin(), _name.end());
+      }
+
+      /// view of the mapped vector words
+      inline vector_view_t vector() const { return vector_view_t(words()); }
+
+      inline basis_view_t basis() const { return basis_view_t(_basis, elemental_bits); }
+
+      /// overwrite the stored vector e.g. when migrating images
+      inline void assign(const vector_view_t& v) {
+        std::copy(v.begin(), v.end(), words());
+      }
+
+
+      /// printer for symbol
+
+      friend std::ostream& operator<<(std::ostream& os, const flat_symbol& s) {
+        os << s._name;
+        return os;
+      }
+
+      ///////////////////////////////////////////
+      /// SDM bitvector delegated properties
+      ///////////////////////////////////////////
+
+      inline const std::size_t count() const {
+        return vector().count();
+      }
+
+      /// semantic density
+
+      inline const double density() const {
+        return vector().density();
+      }
+
+      ///////////////////////////////////////////
+      // semantic_vector measurement functions //
+      ///////////////////////////////////////////
+
+      inline const std::size_t distance(const flat_symbol& v) const {
+        return vector().distance(v.vector());
+      }
+
+      inline const std::size_t inner(const flat_symbol& v) const {
+        return vector().inner(v.vector());
+      }
+
+      inline std::size_t countsum(const flat_symbol& v) const {
+        return vector().countsum(v.vector());
+      }
+
+      inline double similarity(const flat_symbol& v) const {
+        return vector().similarity(v.vector());
+      }
+
+      inline double overlap(const flat_symbol& v) const {
+        return vector().overlap(v.vector());
+      }
+
+
+      /////////////////////////
+      /// learning utilities //
+      /////////////////////////
+
+      inline void superpose(const flat_symbol& v, int rotations = 0) {
+        superpose_basis(words(), dimensions, v._basis, elemental_bits, v._dither, rotations);
+      }
+
+      /// superpose set and clear masks folded from many bases (see
+      /// mask_basis) in one pass
+      inline void superpose(const element_t* set, const element_t* clear) {
+        superpose_masks(words(), set, clear, n_elements);
+      }
+
+      inline void subtract(const flat_symbol& v, int rotations=0) {
+        // XXX TODO as for symbol
+      }
+
+    };
+
+  }
+}
@@ -0,0 +1,318 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+#include <boost/interprocess/allocators/allocator.hpp>
+#include <boost/interprocess/containers/vector.hpp>
+
+
+namespace sdm {
+
+  namespace mms {
+
+    namespace bip = boost::interprocess;
+
+    //////////////////////////////////////////////////////////////////////
+    /// hnsw_graph - hierarchical navigable small world graph (Malkov &
+    ///              Yashunin) over the symbols of a space by id, mapped
+    ///              in the image so it persists with the space
+    ///
+    /// the graph holds no vectors: callers supply distances between ids
+    /// (and from a query to an id) so it works over any vector store.
+    /// Changed symbols are queued by mark() and (re)linked in batches by
+    /// link() as a symbol's vector is rarely final when it is created;
+    /// searches should score queued symbols directly.
+    //////////////////////////////////////////////////////////////////////
+
+    template <typename segment_manager_t>
+
+    class hnsw_graph final {
+
+    public:
+
+      typedef bip::allocator<void, segment_manager_t> void_allocator_t;
+
+      /// (distance, id) ordered nearest first
+      typedef std::pair<std::size_t, std::uint32_t> scored_t;
+
+      static constexpr std::uint32_t none = ~std::uint32_t(0);
+      static constexpr unsigned max_level = 16;
+
+    private:
+
+      typedef bip::vector<std::uint32_t, bip::allocator<std::uint32_t, segment_manager_t>> ids_t;
+
+      struct node {
+        std::uint32_t level;
+        std::uint32_t queued;
+        std::uint32_t linked;
+        std::uint32_t upper;   // offset of links above level 0 or none
+      };
+
+      typedef bip::vector<node, bip::allocator<node, segment_manager_t>> nodes_t;
+
+    public:
+
+      hnsw_graph(const unsigned m, const unsigned efc, const void_allocator_t& a)
+        : M(m), M0(2 * m), ef_construction(efc), entry(none), top(0),
+          nodes(a), base(a), upper(a), pending(a) {}
+
+
+      /// links per node above level 0 (twice that at level 0)
+      inline unsigned degree() const { return M; }
+
+      /// number of node slots
+      inline std::size_t size() const { return nodes.size(); }
+
+      /// ids waiting to be linked
+      inline const ids_t& backlog() const { return pending; }
+
+
+      /// id has a new or changed vector
+
+      void mark(const std::uint32_t id) {
+        if (id >= nodes.size()) {
+          nodes.resize(id + 1, node{0, 0, 0, none});
+          base.resize(nodes.size() * (M0 + 1), 0);
+        }
+        if (!nodes[id].queued) {
+          nodes[id].queued = 1;
+          pending.push_back(id);
+        }
+      }
+
+
+      /// link every queued id -- distance(a, b) between ids
+
+      template <typename D>
+      void link(D distance) {
+        for (std::uint32_t id: pending) {
+          insert(id, distance);
+          nodes[id].queued = 0;
+        }
+        pending.clear();
+      }
+
+
+      /// ef approximate nearest linked ids to a query -- distance(id) from
+      /// the query. Answers ascending (distance, id)
+
+      template <typename DQ>
+      void search(DQ distance, const std::size_t ef, std::vector<scored_t>& nearest) const {
+        nearest.clear();
+        if (entry == none) return;
+
+        std::uint32_t ep = entry;
+        for (unsigned lc = top; lc > 0; --lc) ep = greedy(distance, ep, lc);
+
+        search_layer(distance, ep, ef, 0, none, nearest);
+      }
+
+
+    private:
+
+      /// deterministic level from id -- geometric with mL = 1/ln(M)
+
+      inline unsigned level_of(const std::uint32_t id) const {
+        std::uint64_t h = id + 0x9e3779b97f4a7c15ULL;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        const double u = ((h >> 11) + 1) * (1.0 / 9007199254740992.0);
+        const unsigned l = unsigned(-std::log(u) / std::log(double(M)));
+        return l < max_level ? l : max_level;
+      }
+
+      /// links of id at level lc: count followed by slots
+
+      inline std::uint32_t* links(const std::uint32_t id, const unsigned lc) {
+        return (lc == 0)
+          ? &base[std::size_t(id) * (M0 + 1)]
+          : &upper[std::size_t(nodes[id].upper) + (lc - 1) * (M + 1)];
+      }
+
+      inline const std::uint32_t* links(const std::uint32_t id, const unsigned lc) const {
+        return const_cast<hnsw_graph*>(this)->links(id, lc);
+      }
+
+      inline unsigned capacity(const unsigned lc) const { return lc == 0 ? M0 : M; }
+
+
+      /// walk to the nearest node at level lc
+
+      template <typename DQ>
+      std::uint32_t greedy(DQ distance, std::uint32_t ep, const unsigned lc) const {
+        std::size_t d = distance(ep);
+        for (bool moved = true; moved;) {
+          moved = false;
+          const std::uint32_t* ls = links(ep, lc);
+          for (std::uint32_t i = 1; i <= ls[0]; ++i) {
+            const std::size_t e = distance(ls[i]);
+            if (e < d) { d = e; ep = ls[i]; moved = true; }
+          }
+        }
+        return ep;
+      }
+
+
+      /// best first search of level lc from ep keeping ef nearest, never
+      /// answering skip -- answers ascending (distance, id)
+
+      template <typename DQ>
+      void search_layer(DQ distance,
+                        const std::uint32_t ep,
+                        const std::size_t ef,
+                        const unsigned lc,
+                        const std::uint32_t skip,
+                        std::vector<scored_t>& nearest) const {
+
+        std::vector<bool> visited(nodes.size(), false);
+        std::priority_queue<scored_t, std::vector<scored_t>, std::greater<scored_t>> frontier;
+        std::priority_queue<scored_t> found;
+
+        const scored_t start(distance(ep), ep);
+        visited[ep] = true;
+        frontier.push(start);
+        if (ep != skip) found.push(start);
+
+        while (!frontier.empty()) {
+          const scored_t c = frontier.top();
+          if (found.size() >= ef && c.first > found.top().first) break;
+          frontier.pop();
+
+          const std::uint32_t* ls = links(c.second, lc);
+          for (std::uint32_t i = 1; i <= ls[0]; ++i) {
+            const std::uint32_t e = ls[i];
+            if (visited[e]) continue;
+            visited[e] = true;
+            const scored_t s(distance(e), e);
+            if (found.size() < ef || s < found.top()) {
+              frontier.push(s);
+              if (e == skip) continue;
+              found.push(s);
+              if (found.size() > ef) found.pop();
+            }
+          }
+        }
+
+        nearest.resize(found.size());
+        for (std::size_t i = found.size(); i > 0; --i) {
+          nearest[i - 1] = found.top();
+          found.pop();
+        }
+      }
+
+
+      /// neighbour selection heuristic: keep candidates nearer to the
+      /// base than to any already kept then top up with the nearest
+
+      template <typename D>
+      void select(const std::vector<scored_t>& candidates,
+                  const unsigned n,
+                  D distance,
+                  std::vector<std::uint32_t>& kept) const {
+        kept.clear();
+        std::vector<std::uint32_t> pruned;
+        for (const scored_t& c: candidates) {
+          if (kept.size() >= n) break;
+          bool diverse = true;
+          for (std::uint32_t k: kept)
+            if (distance(c.second, k) < c.first) { diverse = false; break; }
+          if (diverse) kept.push_back(c.second);
+          else pruned.push_back(c.second);
+        }
+        for (std::size_t i = 0; i < pruned.size() && kept.size() < n; ++i) kept.push_back(pruned[i]);
+      }
+
+
+      /// (re)link id at its levels
+
+      template <typename D>
+      void insert(const std::uint32_t id, D distance) {
+        const unsigned level = level_of(id);
+        node& nd = nodes[id];
+        nd.level = level;
+        if (level > 0 && nd.upper == none) {
+          nd.upper = upper.size();
+          upper.resize(upper.size() + level * (M + 1), 0);
+        }
+
+        if (entry == none) {
+          entry = id;
+          top = level;
+          nd.linked = 1;
+          return;
+        }
+
+        auto from = [&](const std::uint32_t e) { return distance(id, e); };
+
+        // descend to the levels of the new node
+        std::uint32_t ep = entry;
+        for (unsigned lc = top; lc > level; --lc) ep = greedy(from, ep, lc);
+
+        std::vector<scored_t> nearest;
+        std::vector<std::uint32_t> kept;
+
+        for (unsigned lc = std::min(level, top) + 1; lc-- > 0;) {
+          search_layer(from, ep, ef_construction, lc, id, nearest);
+          if (nearest.empty()) continue;
+
+          select(nearest, capacity(lc), distance, kept);
+          std::uint32_t* ls = links(id, lc);
+          ls[0] = kept.size();
+          std::copy(kept.begin(), kept.end(), ls + 1);
+
+          // back links shrinking full neighbour lists
+          for (std::uint32_t e: kept) connect(e, id, lc, distance);
+          ep = nearest.front().second;
+        }
+
+        nd.linked = 1;
+        if (level > top) {
+          entry = id;
+          top = level;
+        }
+      }
+
+
+      /// add link e -> id at level lc
+
+      template <typename D>
+      void connect(const std::uint32_t e, const std::uint32_t id, const unsigned lc, D distance) {
+        if (nodes[e].level < lc) return;
+        std::uint32_t* ls = links(e, lc);
+        for (std::uint32_t i = 1; i <= ls[0]; ++i) if (ls[i] == id) return;
+
+        if (ls[0] < capacity(lc)) {
+          ls[++ls[0]] = id;
+          return;
+        }
+
+        std::vector<scored_t> candidates;
+        candidates.push_back(scored_t(distance(e, id), id));
+        for (std::uint32_t i = 1; i <= ls[0]; ++i) candidates.push_back(scored_t(distance(e, ls[i]), ls[i]));
+        std::sort(candidates.begin(), candidates.end());
+
+        std::vector<std::uint32_t> kept;
+        select(candidates, capacity(lc), distance, kept);
+        ls[0] = kept.size();
+        std::copy(kept.begin(), kept.end(), ls + 1);
+      }
+
+
+      const unsigned M;
+      const unsigned M0;
+      const unsigned ef_construction;
+      std::uint32_t entry;
+      unsigned top;
+      nodes_t nodes;
+      ids_t base;
+      ids_t upper;
+      ids_t pending;
+    };
+  }
+}
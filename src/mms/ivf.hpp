@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <boost/interprocess/allocators/allocator.hpp>
+#include <boost/interprocess/containers/vector.hpp>
+
+#include "bitvector_kernels.hpp"
+#include "bucket_index.hpp"
+
+
+namespace sdm {
+
+  namespace mms {
+
+    namespace bip = boost::interprocess;
+
+    //////////////////////////////////////////////////////////////////////
+    /// ivf_index - inverted file of the symbols of a space: vectors are
+    ///             clustered into partitions around binary centroids and
+    ///             a query scans only the symbols of the few partitions
+    ///             with centroids nearest to it
+    ///
+    /// centroids are found by binary k-means under hamming distance: each
+    /// round assigns every vector to its nearest centroid then votes each
+    /// centroid afresh from its members. Semantic vectors are sparse so a
+    /// strict majority vote would leave centroids all but empty; instead a
+    /// centroid keeps the most voted bits up to the mean popcount of its
+    /// members. Symbols that change after a build are queued and filed
+    /// under their nearest centroid in batches; queries should scan the
+    /// queue as well.
+    //////////////////////////////////////////////////////////////////////
+
+    template <typename segment_manager_t>
+
+    class ivf_index final {
+
+    public:
+
+      typedef bip::allocator<void, segment_manager_t> void_allocator_t;
+      typedef kernels::word_t word_t;
+
+    private:
+
+      typedef bip::vector<word_t, bip::allocator<word_t, segment_manager_t>> words_t;
+      typedef bip::vector<std::uint32_t, bip::allocator<std::uint32_t, segment_manager_t>> ids_t;
+
+    public:
+
+      /// c partitions of vectors of n words
+      ivf_index(const unsigned c, const std::size_t n, const void_allocator_t& a)
+        : n_words(n), centroids(a), queued(a), pending(a), lists(1, a) {
+        centroids.resize(std::size_t(c) * n, 0);
+      }
+
+
+      /// number of partitions
+      inline unsigned partitions() const { return centroids.size() / n_words; }
+
+      /// ids waiting to be filed
+      inline const ids_t& backlog() const { return pending; }
+
+
+      /// cluster n vectors row(i) with rounds of k-means and file them
+
+      template <typename R>
+      void build(R row, const std::size_t n, const unsigned rounds) {
+        const kernels::popcount_kernels& kernel = kernels::dispatch();
+        const unsigned c = partitions();
+        const std::size_t bits = n_words * 64;
+        if (n == 0) return;
+
+        // seed with vectors spread over the space
+        for (unsigned p = 0; p < c; ++p) {
+          const word_t* v = row(std::size_t(p) * n / c);
+          std::copy(v, v + n_words, centroid(p));
+        }
+
+        std::vector<std::uint32_t> assigned(n);
+        std::vector<std::uint32_t> votes;
+
+        for (unsigned r = 0; r < rounds; ++r) {
+          for (std::size_t i = 0; i < n; ++i) assigned[i] = nearest(row(i));
+          if (r + 1 == rounds) break;
+
+          // vote each centroid from its members
+          votes.assign(std::size_t(c) * bits, 0);
+          std::vector<std::size_t> members(c, 0), weight(c, 0);
+          for (std::size_t i = 0; i < n; ++i) {
+            const word_t* v = row(i);
+            std::uint32_t* tally = &votes[std::size_t(assigned[i]) * bits];
+            for (std::size_t w = 0; w < n_words; ++w)
+              for (word_t x = v[w]; x; x &= x - 1) ++tally[w * 64 + __builtin_ctzll(x)];
+            ++members[assigned[i]];
+            weight[assigned[i]] += kernel.count(v, n_words);
+          }
+
+          std::vector<std::pair<std::uint32_t, std::uint32_t>> ranked(bits);
+          for (unsigned p = 0; p < c; ++p) {
+            if (members[p] == 0) continue;
+            const std::uint32_t* tally = &votes[std::size_t(p) * bits];
+            for (std::size_t b = 0; b < bits; ++b) ranked[b] = std::make_pair(tally[b], std::uint32_t(b));
+            const std::size_t keep = std::min(bits, (weight[p] + members[p] / 2) / members[p]);
+            std::nth_element(ranked.begin(), ranked.begin() + keep, ranked.end(),
+                             [](const std::pair<std::uint32_t, std::uint32_t>& a,
+                                const std::pair<std::uint32_t, std::uint32_t>& b) { return a > b; });
+            word_t* cv = centroid(p);
+            std::fill(cv, cv + n_words, 0);
+            for (std::size_t k = 0; k < keep && ranked[k].first > 0; ++k)
+              cv[ranked[k].second / 64] |= word_t(1) << (ranked[k].second % 64);
+          }
+        }
+
+        for (std::size_t i = 0; i < n; ++i) {
+          const std::uint64_t key = assigned[i];
+          lists.file(i, &key);
+        }
+        for (std::uint32_t id: pending) queued[id] = 0;
+        pending.clear();
+      }
+
+
+      /// id has a new or changed vector
+
+      void mark(const std::uint32_t id) {
+        if (id >= queued.size()) queued.resize(id + 1, 0);
+        if (!queued[id]) {
+          queued[id] = 1;
+          pending.push_back(id);
+        }
+      }
+
+
+      /// file every queued id under its nearest centroid
+
+      template <typename R>
+      void assign(R row) {
+        for (std::uint32_t id: pending) {
+          const std::uint64_t key = nearest(row(id));
+          lists.file(id, &key);
+          queued[id] = 0;
+        }
+        pending.clear();
+      }
+
+
+      /// ids filed in the nprobe partitions nearest q together with any
+      /// still queued -- answers ascending unique ids
+
+      void candidates(const word_t* q, const std::size_t nprobe, std::vector<std::size_t>& ids) const {
+        const kernels::popcount_kernels& kernel = kernels::dispatch();
+        const unsigned c = partitions();
+
+        std::vector<std::pair<std::size_t, unsigned>> near(c);
+        for (unsigned p = 0; p < c; ++p) near[p] = std::make_pair(kernel.distance(q, centroid(p), n_words), p);
+        const std::size_t probes = std::min<std::size_t>(std::max<std::size_t>(nprobe, 1), c);
+        std::partial_sort(near.begin(), near.begin() + probes, near.end());
+
+        auto collect = [&ids](const std::uint32_t id) { ids.push_back(id); };
+        for (std::size_t i = 0; i < probes; ++i) lists.bucket(0, near[i].second, collect);
+        ids.insert(ids.end(), pending.begin(), pending.end());
+
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+      }
+
+
+    private:
+
+      inline word_t* centroid(const unsigned p) { return &centroids[std::size_t(p) * n_words]; }
+
+      inline const word_t* centroid(const unsigned p) const { return &centroids[std::size_t(p) * n_words]; }
+
+      /// partition with the centroid nearest v
+
+      inline unsigned nearest(const word_t* v) const {
+        const kernels::popcount_kernels& kernel = kernels::dispatch();
+        unsigned best = 0;
+        std::size_t d = ~std::size_t(0);
+        for (unsigned p = 0; p < partitions(); ++p) {
+          const std::size_t e = kernel.distance(v, centroid(p), n_words);
+          if (e < d) { d = e; best = p; }
+        }
+        return best;
+      }
+
+      const std::size_t n_words;
+      words_t centroids;
+      ids_t queued;
+      ids_t pending;
+      bucket_index<segment_manager_t> lists;
+    };
+  }
+}
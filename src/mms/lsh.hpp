@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <boost/interprocess/allocators/allocator.hpp>
+#include <boost/interprocess/containers/vector.hpp>
+
+#include "bitvector_kernels.hpp"
+#include "bucket_index.hpp"
+
+
+namespace sdm {
+
+  namespace mms {
+
+    namespace bip = boost::interprocess;
+
+    //////////////////////////////////////////////////////////////////////
+    /// lsh_index - bit sampling locality sensitive hash (Indyk & Motwani)
+    ///             of the symbols of a space: each of L tables files a
+    ///             symbol under k of its bits sampled at fixed positions
+    ///
+    /// two vectors at hamming distance d out of D bits share a table key
+    /// with probability (1 - d/D)^k. Multi-probe lookups (Lv et al.) also
+    /// visit the keys a few bits away from the query's so fewer tables
+    /// are needed for the same recall. Keys are refiled as symbols change.
+    //////////////////////////////////////////////////////////////////////
+
+    template <typename segment_manager_t>
+
+    class lsh_index final {
+
+    public:
+
+      typedef bip::allocator<void, segment_manager_t> void_allocator_t;
+      typedef kernels::word_t word_t;
+
+      /// widest key supported
+      static constexpr unsigned max_bits = 64;
+
+      /// can L tables of k bits be sampled from n words
+      static inline bool valid(const unsigned l, const unsigned k, const std::size_t n) {
+        return l > 0 && k > 0 && k <= max_bits && k <= n * 64;
+      }
+
+      /// sample k bit positions of n words for each of l tables -- the
+      /// positions are fixed by seed
+      lsh_index(const unsigned l, const unsigned k, const std::size_t n,
+                const std::uint64_t seed, const void_allocator_t& a)
+        : n_bits(k), positions(a), buckets(l, a) {
+
+        std::uint64_t s = seed;
+        positions.reserve(std::size_t(l) * k);
+        for (unsigned t = 0; t < l; ++t) {
+          std::vector<std::uint32_t> sample;
+          while (sample.size() < k) {
+            const std::uint32_t b = mix(s += golden) % (n * 64);
+            if (std::find(sample.begin(), sample.end(), b) == sample.end()) sample.push_back(b);
+          }
+          positions.insert(positions.end(), sample.begin(), sample.end());
+        }
+      }
+
+
+      /// number of tables
+      inline unsigned tables() const { return buckets.tables(); }
+
+      /// bits sampled per table
+      inline unsigned bits() const { return n_bits; }
+
+
+      /// file vector v as symbol id -- only changed keys are moved
+
+      void file(const std::uint32_t id, const word_t* v) {
+        std::vector<std::uint64_t> keys(tables());
+        for (unsigned t = 0; t < tables(); ++t) keys[t] = key(t, v);
+        buckets.file(id, keys.data());
+      }
+
+
+      /// ids sharing a key with q in any table, probing up to probes
+      /// further keys per table in order of the number of bits flipped
+      /// (one then two) -- answers ascending unique ids or false when more
+      /// than budget ids are visited as a scan is then the cheaper way
+
+      bool candidates(const word_t* q,
+                      const std::size_t probes,
+                      const std::size_t budget,
+                      std::vector<std::size_t>& ids) const {
+        auto collect = [&ids](const std::uint32_t id) { ids.push_back(id); };
+        std::size_t visited = 0;
+
+        for (unsigned t = 0; t < tables(); ++t) {
+          const std::uint64_t h = key(t, q);
+          visited += buckets.bucket(t, h, collect);
+
+          std::size_t p = 0;
+          for (unsigned i = 0; i < n_bits && p < probes; ++i, ++p)
+            visited += buckets.bucket(t, h ^ (std::uint64_t(1) << i), collect);
+          for (unsigned i = 0; i < n_bits && p < probes; ++i)
+            for (unsigned j = i + 1; j < n_bits && p < probes; ++j, ++p)
+              visited += buckets.bucket(t, h ^ (std::uint64_t(1) << i) ^ (std::uint64_t(1) << j), collect);
+
+          if (visited > budget) return false;
+        }
+
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        return true;
+      }
+
+
+    private:
+
+      static constexpr std::uint64_t golden = 0x9e3779b97f4a7c15ULL;
+
+      /// sampled bits of v for table t
+
+      inline std::uint64_t key(const unsigned t, const word_t* v) const {
+        const std::uint32_t* b = &positions[std::size_t(t) * n_bits];
+        std::uint64_t h = 0;
+        for (unsigned i = 0; i < n_bits; ++i)
+          h |= ((v[b[i] / 64] >> (b[i] % 64)) & 1) << i;
+        return h;
+      }
+
+      /// splitmix64 finaliser
+
+      static inline std::uint64_t mix(std::uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+      }
+
+      const unsigned n_bits;
+      bip::vector<std::uint32_t, bip::allocator<std::uint32_t, segment_manager_t>> positions;
+      bucket_index<segment_manager_t> buckets;
+    };
+  }
+}
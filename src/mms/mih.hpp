@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "bitvector_kernels.hpp"
+#include "bucket_index.hpp"
+
+
+namespace sdm {
+
+  namespace mms {
+
+    //////////////////////////////////////////////////////////////////////
+    /// multi-index hashing (Norouzi et al.) -- vectors are cut into one
+    /// substring per bucket table and filed under a hash of each
+    /// substring. If two vectors are within hamming radius r then some
+    /// substring pair is within r/m of each other (pigeonhole) so probing
+    /// every table within that radius gives an exact candidate set
+    //////////////////////////////////////////////////////////////////////
+
+    namespace mih {
+
+      using kernels::word_t;
+
+      /// substrings wider than this many words are not supported
+
+      static constexpr std::size_t max_substring = 64;
+
+      /// hash of a substring -- collisions only widen the candidate set
+
+      inline std::uint64_t substring_key(const word_t* w, const std::size_t n) {
+        std::uint64_t h = 0x9e3779b97f4a7c15ULL ^ n;
+        for (std::size_t i = 0; i < n; ++i) {
+          h ^= w[i];
+          // splitmix64 finaliser
+          h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+          h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+          h ^= h >> 31;
+        }
+        return h;
+      }
+
+      /// can a vector of n words be cut into m substrings
+
+      inline bool valid_tables(const unsigned m, const std::size_t n) {
+        return m > 0 && n % m == 0 && n / m <= max_substring;
+      }
+
+
+      /// file vector v of n words as symbol id
+
+      template <typename segment_manager_t>
+      inline void file(bucket_index<segment_manager_t>& buckets,
+                       const std::uint32_t id,
+                       const word_t* v,
+                       const std::size_t n) {
+        const unsigned m = buckets.tables();
+        const std::size_t w = n / m;
+        std::vector<std::uint64_t> keys(m);
+        for (unsigned t = 0; t < m; ++t) keys[t] = substring_key(v + t * w, w);
+        buckets.file(id, keys.data());
+      }
+
+
+      /// ids of every symbol that may be within hamming radius of q;
+      /// answers false when the radius needs more than one bit of probing
+      /// per substring or more than budget ids are visited -- a scan is
+      /// then the cheaper way to get the answer
+
+      template <typename segment_manager_t>
+      bool candidates(const bucket_index<segment_manager_t>& buckets,
+                      const word_t* q,
+                      const std::size_t n,
+                      const std::size_t radius,
+                      const std::size_t budget,
+                      std::vector<std::size_t>& ids) {
+
+        const unsigned m = buckets.tables();
+        const std::size_t w = n / m;
+        const std::size_t probe = radius / m;
+        if (probe > 1) return false;
+
+        std::size_t visited = 0;
+        auto collect = [&ids](const std::uint32_t id) { ids.push_back(id); };
+        word_t s[max_substring];
+
+        for (unsigned t = 0; t < m; ++t) {
+          std::copy(q + t * w, q + (t + 1) * w, s);
+          visited += buckets.bucket(t, substring_key(s, w), collect);
+
+          // substrings one bit away
+          if (probe == 1) {
+            for (std::size_t b = 0; b < w * 64; ++b) {
+              s[b / 64] ^= word_t(1) << (b % 64);
+              visited += buckets.bucket(t, substring_key(s, w), collect);
+              s[b / 64] ^= word_t(1) << (b % 64);
+            }
+          }
+          if (visited > budget) return false;
+        }
+
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        return true;
+      }
+    }
+  }
+}
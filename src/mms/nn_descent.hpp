@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "bitvector_kernels.hpp"
+
+
+namespace sdm {
+
+  namespace mms {
+
+    //////////////////////////////////////////////////////////////////////
+    /// nn_descent - approximate k nearest neighbour graph of the rows of
+    ///              a space under hamming distance (Dong, Charikar & Li)
+    ///
+    /// every row starts with k random neighbours; each round samples the
+    /// neighbours not yet joined (and the reverse neighbours) and scores
+    /// every pair of them on the basis that a neighbour of a neighbour is
+    /// likely a neighbour. Rounds stop once few lists change.
+    ///
+    /// work is split so callers can run it in parallel: init and join
+    /// only read the lists of other rows, so may run for many rows at
+    /// once, while sample and apply change lists and must run alone.
+    /// Randomness is drawn per row from the seed so the graph does not
+    /// depend on the number of threads.
+    //////////////////////////////////////////////////////////////////////
+
+    class nn_descent final {
+
+    public:
+
+      typedef kernels::word_t word_t;
+
+      struct entry {
+        std::size_t distance;
+        std::uint32_t id;
+        bool fresh;           // not yet joined
+
+        /// nearer first and ties broken by id
+        inline bool operator< (const entry& e) const {
+          return distance < e.distance || (distance == e.distance && id < e.id);
+        }
+      };
+
+      /// offer of id as a neighbour of to
+      struct proposal {
+        std::uint32_t to;
+        std::uint32_t id;
+        std::size_t distance;
+      };
+
+
+      /// graph of k neighbours of m rows of n words
+      nn_descent(const std::size_t m, const std::size_t n, const std::size_t k, const std::uint64_t seed)
+        : m_rows(m), n_words(n), K(m > 1 ? std::min(k, m - 1) : 0), seed(seed),
+          lists(m * K), fresh(m), stale(m), kernel(kernels::dispatch()) {}
+
+
+      /// number of rows
+      inline std::size_t size() const { return m_rows; }
+
+      /// neighbours per row
+      inline std::size_t degree() const { return K; }
+
+      /// neighbours of row v nearest first
+      inline const entry* neighbours(const std::size_t v) const { return &lists[v * K]; }
+
+
+      /// K distinct random neighbours of row v
+
+      template <typename R>
+      void init(const std::size_t v, R row) {
+        entry* l = &lists[v * K];
+        std::uint64_t s = seed ^ (v * golden);
+        for (std::size_t i = 0; i < K;) {
+          const std::uint32_t u = mix(s += golden) % m_rows;
+          if (u == v || std::any_of(l, l + i, [u](const entry& e) { return e.id == u; })) continue;
+          l[i++] = entry{kernel.distance(row(v), row(u), n_words), u, true};
+        }
+        std::sort(l, l + K);
+      }
+
+
+      /// choose the rows each row joins this round: up to rho K of its
+      /// fresh neighbours and up to K of the rows that chose them, with
+      /// its joined neighbours and up to rho K of those that joined it.
+      /// The sparsest rows are near to most others so their reverse
+      /// lists are long and sampling them fully helps
+
+      void sample(const double rho, const unsigned round) {
+        const std::size_t s = std::max<std::size_t>(1, std::size_t(rho * K));
+        std::vector<std::vector<std::uint32_t>> rfresh(m_rows), rstale(m_rows);
+
+        for (std::size_t v = 0; v < m_rows; ++v) {
+          fresh[v].clear();
+          stale[v].clear();
+          entry* l = &lists[v * K];
+          for (std::size_t i = 0; i < K; ++i) (l[i].fresh ? fresh[v] : stale[v]).push_back(l[i].id);
+          shuffle(fresh[v], v, round);
+          if (fresh[v].size() > s) fresh[v].resize(s);
+          // sampled neighbours are joined this round
+          for (std::size_t i = 0; i < K; ++i)
+            if (l[i].fresh && std::find(fresh[v].begin(), fresh[v].end(), l[i].id) != fresh[v].end()) l[i].fresh = false;
+          for (std::uint32_t u: fresh[v]) rfresh[u].push_back(v);
+          for (std::uint32_t u: stale[v]) rstale[u].push_back(v);
+        }
+
+        for (std::size_t v = 0; v < m_rows; ++v) {
+          merge(fresh[v], rfresh[v], K, v, round);
+          merge(stale[v], rstale[v], s, v, ~round);
+        }
+      }
+
+
+      /// score the pairs of rows joined by row v offering those nearer
+      /// than a current neighbour
+
+      template <typename R>
+      void join(const std::size_t v, R row, std::vector<proposal>& out) const {
+        const std::vector<std::uint32_t>& a = fresh[v];
+        const std::vector<std::uint32_t>& b = stale[v];
+
+        auto score = [&](const std::uint32_t x, const std::uint32_t y) {
+          if (x == y) return;
+          const std::size_t d = kernel.distance(row(x), row(y), n_words);
+          if (entry{d, y, false} < worst(x)) out.push_back(proposal{x, y, d});
+          if (entry{d, x, false} < worst(y)) out.push_back(proposal{y, x, d});
+        };
+
+        for (std::size_t i = 0; i < a.size(); ++i) {
+          for (std::size_t j = i + 1; j < a.size(); ++j) score(a[i], a[j]);
+          for (std::uint32_t y: b) score(a[i], y);
+        }
+      }
+
+
+      /// take up proposals -- answers the number of lists changed
+
+      std::size_t apply(const std::vector<proposal>& ps) {
+        std::size_t changed = 0;
+        if (K == 0) return 0;
+        for (const proposal& p: ps) {
+          entry* l = &lists[std::size_t(p.to) * K];
+          const entry e{p.distance, p.id, true};
+          if (!(e < l[K - 1]) || std::any_of(l, l + K, [&p](const entry& x) { return x.id == p.id; })) continue;
+          // insertion into the sorted list displacing the worst
+          entry* at = std::upper_bound(l, l + K - 1, e);
+          std::copy_backward(at, l + K - 1, l + K);
+          *at = e;
+          ++changed;
+        }
+        return changed;
+      }
+
+
+    private:
+
+      static constexpr std::uint64_t golden = 0x9e3779b97f4a7c15ULL;
+
+      inline const entry& worst(const std::uint32_t v) const { return lists[std::size_t(v) * K + K - 1]; }
+
+      /// splitmix64 finaliser
+      static inline std::uint64_t mix(std::uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+      }
+
+      /// fisher-yates shuffle drawn from (seed, v, round)
+      void shuffle(std::vector<std::uint32_t>& ids, const std::size_t v, const unsigned round) const {
+        std::uint64_t s = seed ^ mix(v * golden + round);
+        for (std::size_t i = ids.size(); i > 1; --i) std::swap(ids[i - 1], ids[mix(s += golden) % i]);
+      }
+
+      /// add a random s of the reverse ids to ids without repeats
+      void merge(std::vector<std::uint32_t>& ids, std::vector<std::uint32_t>& reverse,
+                 const std::size_t s, const std::size_t v, const unsigned round) const {
+        shuffle(reverse, v, round);
+        if (reverse.size() > s) reverse.resize(s);
+        ids.insert(ids.end(), reverse.begin(), reverse.end());
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+      }
+
+      const std::size_t m_rows;
+      const std::size_t n_words;
+      const std::size_t K;
+      const std::uint64_t seed;
+      std::vector<entry> lists;
+      std::vector<std::vector<std::uint32_t>> fresh;
+      std::vector<std::vector<std::uint32_t>> stale;
+      const kernels::popcount_kernels& kernel;
+    };
+  }
+}
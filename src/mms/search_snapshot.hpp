@@ -0,0 +1,202 @@
+#pragma once
+
+#include <boost/align/aligned_allocator.hpp>
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include "sdmconfig.h"
+#include "bitvector_kernels.hpp"
+
+
+namespace sdm {
+
+  namespace mms {
+
+    //////////////////////////////////////////////////////////////////////
+    /// search_snapshot - contiguous copy of every semantic vector in a
+    ///                   space in random access order with popcounts so
+    ///                   scans stream one dense cache aligned matrix
+    ///                   instead of walking the symbol index
+    ///
+    /// the snapshot is a read through cache held in process memory and
+    /// never in the image: rows are appended lazily as the space grows
+    /// and patched when a row is touched by a learning operation. Writes
+    /// made through mutable symbol references must touch() their row.
+    ///
+    /// optionally the rows are also kept in popcount order so a scan can
+    /// binary search the range of counts that can meet its bounds
+    ///
+    /// each row also has a sketch of every sketch_stride'th word, kept
+    /// in its own small matrix, whose hamming distances estimate those
+    /// of whole rows from a sixteenth of their words so a two stage
+    /// search can shortlist candidates before reading whole rows
+    //////////////////////////////////////////////////////////////////////
+
+    template <typename element_t, std::size_t n_elements>
+
+    class search_snapshot final {
+
+    public:
+
+      static constexpr std::size_t alignment = 64;
+
+      static_assert(sizeof(element_t) == sizeof(kernels::word_t), "kernels require 64 bit elements");
+      static_assert((n_elements * sizeof(element_t)) % alignment == 0, "rows must stay aligned");
+
+      typedef std::vector<element_t,
+                          boost::alignment::aligned_allocator<element_t, alignment>> matrix_t;
+
+      /// (popcount, row) in ascending order
+
+      typedef std::pair<unsigned, std::size_t> order_entry_t;
+      typedef std::vector<order_entry_t> order_t;
+
+      /// words sampled from each row into its sketch
+
+      static constexpr std::size_t sketch_words = (n_elements < 16) ? n_elements : 16;
+      static constexpr std::size_t sketch_stride = n_elements / sketch_words;
+
+      search_snapshot() : stale(false), ordering(false) {}
+
+      search_snapshot(const search_snapshot&) = delete;
+      const search_snapshot& operator=(const search_snapshot&) = delete;
+
+
+      /// number of rows in the snapshot
+
+      inline std::size_t rows() const { return counts.size(); }
+
+      /// words of row i
+
+      inline const element_t* row(std::size_t i) const {
+        return matrix.data() + i * n_elements;
+      }
+
+      /// popcount of row i
+
+      inline std::size_t count(std::size_t i) const { return counts[i]; }
+
+      /// sketch_words words of the sketch of row i
+
+      inline const element_t* sketch(std::size_t i) const {
+        return sketches.data() + i * sketch_words;
+      }
+
+      /// sketch of the n_elements words at v into out
+
+      static inline void sketch_of(const element_t* v, element_t* out) {
+        for (std::size_t w = 0; w < sketch_words; ++w) out[w] = v[w * sketch_stride];
+      }
+
+
+      /// row i has changed in the space
+
+      inline void touch(std::size_t i) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (i < rows()) dirty.push_back(i);
+      }
+
+      /// keep (or stop keeping) the rows in popcount order
+
+      inline void order_by_density(bool on) {
+        std::lock_guard<std::mutex> guard(lock);
+        ordering = on;
+        if (!on) order_t().swap(order);
+      }
+
+      inline bool density_ordered() const { return ordering; }
+
+      /// rows in popcount order -- empty unless density ordered
+
+      inline const order_t& by_density() const { return order; }
+
+      /// throw away all rows e.g. when the space is rebuilt
+
+      inline void invalidate() {
+        std::lock_guard<std::mutex> guard(lock);
+        stale = true;
+      }
+
+
+      /// bring the snapshot up to date with space -- queries must not
+      /// overlap writes to the space, as for the symbol index itself
+
+      template <typename space_t>
+      void refresh(space_t& space) {
+        std::lock_guard<std::mutex> guard(lock);
+
+        if (stale) {
+          matrix.clear();
+          sketches.clear();
+          counts.clear();
+          dirty.clear();
+          order.clear();
+          stale = false;
+        }
+
+        // a handful of changes are patched into the order, more resort it
+        const std::size_t m = space.entries();
+        const std::size_t from = rows();
+        const bool patch = ordering && order.size() == from && dirty.size() + (m - from) <= max_patch;
+
+        // patch touched rows
+        std::sort(dirty.begin(), dirty.end());
+        dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+        
+        for (std::size_t i: dirty) {
+          const unsigned was = counts[i];
+          copy_row(space, i);
+          if (patch && counts[i] != was) {
+            order.erase(std::lower_bound(order.begin(), order.end(), order_entry_t(was, i)));
+            order.insert(std::lower_bound(order.begin(), order.end(), order_entry_t(counts[i], i)),
+                         order_entry_t(counts[i], i));
+          }
+        }
+        dirty.clear();
+
+        // append new rows
+        if (m > from) {
+          matrix.resize(m * n_elements);
+          sketches.resize(m * sketch_words);
+          counts.resize(m);
+          for (std::size_t i = from; i < m; ++i) {
+            copy_row(space, i);
+            if (patch) order.insert(std::upper_bound(order.begin(), order.end(), order_entry_t(counts[i], i)),
+                                    order_entry_t(counts[i], i));
+          }
+        }
+
+        if (ordering && !patch) {
+          order.resize(rows());
+          for (std::size_t i = 0; i < rows(); ++i) order[i] = order_entry_t(counts[i], i);
+          std::sort(order.begin(), order.end());
+        }
+      }
+
+
+    private:
+
+      template <typename space_t>
+      inline void copy_row(space_t& space, std::size_t i) {
+        auto v = space[i].vector();
+        element_t* r = matrix.data() + i * n_elements;
+        std::copy(v.begin(), v.end(), r);
+        sketch_of(r, sketches.data() + i * sketch_words);
+        counts[i] = kernels::dispatch().count(reinterpret_cast<const kernels::word_t*>(r), n_elements);
+      }
+
+      // changes beyond this many rows resort rather than patch the order
+      static constexpr std::size_t max_patch = 64;
+
+      matrix_t matrix;
+      matrix_t sketches;
+      std::vector<unsigned> counts;
+      std::vector<std::size_t> dirty;
+      order_t order;
+      bool stale;
+      bool ordering;
+      std::mutex lock;
+    };
+  }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "bitvector_kernels.hpp"
+
+
+namespace sdm {
+
+  namespace mms {
+
+    //////////////////////////////////////////////////////////////////////
+    /// similarity_join - all pairs similarity of the rows of a space
+    ///
+    /// rows are cut into blocks of block_rows (two blocks together fit
+    /// in L2) and only the upper triangle of block pairs is visited, so
+    /// each unordered pair is scored once. Within a pair of blocks the
+    /// kernel's distance_tile scores tile_rows x tile_rows rows at a
+    /// time, loading each word once for several pairs and giving up once
+    /// none of them can be within the radius. Block rows are
+    /// independent so callers can run them in parallel, each emitting
+    /// into its own buffer.
+    //////////////////////////////////////////////////////////////////////
+
+    class similarity_join final {
+
+    public:
+
+      typedef kernels::word_t word_t;
+
+      /// rows per block: 64 rows of 256 words is 128k
+      static constexpr std::size_t block_rows = 64;
+
+      /// join m rows of n words keeping pairs with similarity of at least mlb
+      similarity_join(const std::size_t m, const std::size_t n, const double mlb)
+        : m_rows(m), n_words(n), dimensions(n * 64),
+          // hamming distance can exceed neither the radius nor the
+          // difference of popcounts
+          radius(mlb > 0 ? std::size_t((1.0 - mlb) * n * 64) + 1 : n * 64),
+          threshold(mlb), kernel(kernels::dispatch()) {}
+
+
+      /// number of block rows
+      inline std::size_t blocks() const { return (m_rows + block_rows - 1) / block_rows; }
+
+
+      /// every pair (i, j) with i <= j and i in block row b as
+      /// f(i, j, similarity, distance) -- row(i) gives the words and
+      /// count(i) the popcount of row i
+
+      template <typename R, typename C, typename F>
+      void join(const std::size_t b, R row, C count, F f) const {
+        const std::size_t t = kernels::tile_rows;
+        const std::size_t ia = b * block_rows;
+        const std::size_t ib = std::min(ia + block_rows, m_rows);
+
+        for (std::size_t ja = ia; ja < m_rows; ja += block_rows) {
+          const std::size_t jb = std::min(ja + block_rows, m_rows);
+
+          for (std::size_t i = ia; i < ib; i += t) {
+            const word_t* as[kernels::tile_rows];
+            for (std::size_t u = 0; u < t; ++u) as[u] = row(std::min(i + u, ib - 1));
+
+            // on the diagonal block only tiles on or above the diagonal
+            for (std::size_t j = (ja == ia) ? i : ja; j < jb; j += t) {
+              const word_t* bs[kernels::tile_rows];
+              for (std::size_t u = 0; u < t; ++u) bs[u] = row(std::min(j + u, jb - 1));
+
+              // hamming distance is at least the difference in popcounts
+              bool near = false;
+              for (std::size_t u = 0; u < t && !near; ++u)
+                for (std::size_t v = 0; v < t && !near; ++v) {
+                  const std::size_t ci = count(std::min(i + u, ib - 1));
+                  const std::size_t cj = count(std::min(j + v, jb - 1));
+                  near = (ci > cj ? ci - cj : cj - ci) <= radius;
+                }
+              if (!near) continue;
+
+              std::size_t d[kernels::tile_rows * kernels::tile_rows];
+              kernel.distance_tile(as, bs, n_words, radius, d);
+
+              for (std::size_t u = 0; u < t && i + u < ib; ++u)
+                for (std::size_t v = 0; v < t && j + v < jb; ++v) {
+                  if (j + v < i + u || d[u * t + v] > radius) continue;
+                  const double similarity = 1.0 - double(d[u * t + v]) / dimensions;
+                  if (similarity >= threshold) f(i + u, j + v, similarity, d[u * t + v]);
+                }
+            }
+          }
+        }
+      }
+
+
+    private:
+
+      const std::size_t m_rows;
+      const std::size_t n_words;
+      const double dimensions;
+      const std::size_t radius;
+      const double threshold;
+      const kernels::popcount_kernels& kernel;
+    };
+  }
+}
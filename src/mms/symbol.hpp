@@ -37,10 +37,21 @@ namespace sdm {
                               SDM_VECTOR_ELEMENT_TYPE,
                               SDM_VECTOR_ELEMS> semantic_vector_t;
 
+      // zero copy read only view of the stored semantic vector
+
+      typedef bitvector_view<SDM_VECTOR_ELEMENT_TYPE,
+                             SDM_VECTOR_ELEMS> vector_view_t;
+
       // sparse stored (immutable) fingerprint
 
       typedef elemental_vector<segment_manager_t, unsigned> elemental_vector_t;
 
+      typedef elemental_view<unsigned> basis_view_t;
+
+      // image layout tag -- see symbol_space
+
+      static constexpr unsigned layout = SDM_LAYOUT_BOXED;
+
       // state
 
 
@@ -78,9 +89,15 @@ namespace sdm {
         return std::string(_name.begin(), _name.end());
       }
       
-      inline semantic_vector_t vector() { return _vector; }
+      /// view of the mapped vector words -- no copy no allocation
+      inline vector_view_t vector() const { return vector_view_t(_vector.data()); }
+
+      inline basis_view_t basis() const { return basis_view_t(_basis.data(), _basis.size()); }
 
-      inline const elemental_vector_t basis() const { return _basis; }
+      /// overwrite the stored vector e.g. when migrating images
+      inline void assign(const vector_view_t& v) {
+        std::copy(v.begin(), v.end(), _vector.begin());
+      }
       
 
       /// printer for symbol XXX might be useful to dump symbol representation to stream 
@@ -94,13 +111,13 @@ namespace sdm {
       /// SDM bitvector/semantic_vector delegated properties
       ///////////////////////////////////////////////////////
       
-      inline const std::size_t count() {
+      inline const std::size_t count() const {
         return _vector.count();
       }
 
       /// semantic density
       
-      inline const double density() {
+      inline const double density() const {
         return _vector.density();
       }
         
@@ -110,31 +127,31 @@ namespace sdm {
 
       /// semantic distance is the Hamming distance
       
-      inline const std::size_t distance(const symbol& v) {
+      inline const std::size_t distance(const symbol& v) const {
         return _vector.distance(v._vector);
       }
     
       /// inner product is the commonality/overlap
       
-      inline const std::size_t inner(const symbol& v) {
-        return _vector.distance(v._vector);
+      inline const std::size_t inner(const symbol& v) const {
+        return _vector.inner(v._vector);
       }
       
       /// semantic union
       
-      inline std::size_t countsum(const symbol& v) {
+      inline std::size_t countsum(const symbol& v) const {
         return _vector.countsum(v._vector);
       }
     
       /// semantic similarity
       
-      inline double similarity(const symbol& v) {
+      inline double similarity(const symbol& v) const {
         return _vector.similarity(v._vector);
       }
     
       /// semantic overlap
       
-      inline double overlap(const symbol& v) {
+      inline double overlap(const symbol& v) const {
         return _vector.overlap(v._vector);
       }
     
@@ -144,25 +161,14 @@ namespace sdm {
       /////////////////////////
 
       inline void superpose(const symbol& v, int rotations = 0) {
-        sdm_prob_t p = v._dither;
-        unsigned h = floor(p * v._basis.size());
-        
-        // set h
-        for (auto it = v._basis.begin(); it < (v._basis.begin() + h); ++it) {
-          unsigned r = (*it + rotations) % dimensions;
-          unsigned i = r / (sizeof(element_t) * CHAR_BITS);
-          unsigned b = r % (sizeof(element_t) * CHAR_BITS);
-          _vector[i] |= (ONE << b);
-        }
-        
-        // clear remainder
-        for (auto it = v._basis.begin() + h; it < v._basis.end(); ++it) {
-          unsigned r = (*it + rotations) % dimensions;
-          unsigned i = r / (sizeof(element_t) * CHAR_BITS);
-          unsigned b = r % (sizeof(element_t) * CHAR_BITS);
-          _vector[i] &= ~(ONE << b);
-        } 
+        superpose_basis(_vector.data(), dimensions, v._basis.data(), v._basis.size(),
+                        v._dither, rotations);
+      }
 
+      /// superpose set and clear masks folded from many bases (see
+      /// mask_basis) in one pass
+      inline void superpose(const element_t* set, const element_t* clear) {
+        superpose_masks(_vector.data(), set, clear, n_elements);
       }
 
       ///////////////////////////////////////////////////////////////////////////
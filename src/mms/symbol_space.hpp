@@ -5,13 +5,25 @@
 #include <boost/interprocess/containers/vector.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/ranked_index.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/random_access_index.hpp>
 #include <boost/multi_index/member.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_view.hpp>
 #include <boost/optional.hpp>
+#include <algorithm>
+#include <stdexcept>
 
-// symbol type
+// symbol types
 #include "symbol.hpp"
+#include "flat_symbol.hpp"
+#include "search_snapshot.hpp"
+#include "mih.hpp"
+#include "hnsw.hpp"
+#include "lsh.hpp"
+#include "ivf.hpp"
+#include "bit_postings.hpp"
 
 
 #if HAVE_DISPATCH
@@ -36,13 +48,18 @@ namespace sdm {
      * source or inlined in application code; the important
      * implementation details are the types and sizes of the vectors
      * of the underlying vector space and the sparsity of the random
-     * (elemental) vectors
+     * (elemental) vectors and the layout of the stored symbol records:
+     * symbol (boxed vectors) or flat_symbol (inline vectors) and
+     * whether the name order is ranked (only false to read images
+     * written before it was)
      */
 
     template <typename VectorElementType,
               std::size_t VectorElems,
               std::size_t ElementalBits,
-              class SegmentClass>
+              class SegmentClass,
+              template <typename, typename, typename> class SymbolClass = symbol,
+              bool RankedNames = true>
 
     /// symbol_space - managed memory segment with multi index container for symbols
     
@@ -64,11 +81,26 @@ namespace sdm {
       // implement symbol type
 
     public:
-      typedef symbol<segment_manager_t, shared_string_t, void_allocator_t> symbol_t;
+      typedef SymbolClass<segment_manager_t, shared_string_t, void_allocator_t> symbol_t;
 
       // symbol_t dependant types
-      typedef typename symbol_t::elemental_vector_t basis_t;
-      typedef typename symbol_t::semantic_vector_t vector_t;
+      typedef typename symbol_t::basis_view_t basis_view_t;
+      typedef typename symbol_t::vector_view_t vector_view_t;
+
+      // dense copy of the vectors for scans
+      typedef search_snapshot<typename symbol_t::element_t, symbol_t::n_elements> snapshot_t;
+
+      // search indexes stored in the image
+      typedef bucket_index<segment_manager_t> bucket_index_t;
+      typedef hnsw_graph<segment_manager_t> hnsw_t;
+      typedef lsh_index<segment_manager_t> lsh_t;
+      typedef ivf_index<segment_manager_t> ivf_t;
+      typedef bit_postings<segment_manager_t> postings_t;
+
+      /// layout tag of images holding spaces of this type
+      static inline unsigned image_layout() {
+        return symbol_t::layout | (RankedNames ? SDM_LAYOUT_RANKED : 0);
+      }
 
     private:
       
@@ -88,11 +120,40 @@ namespace sdm {
         return shared_string_t(s, allocator); 
       }
 
+      // names are looked up by view so that probing an index never
+      // allocates a key in the segment: hashing is over the characters
+      // as boost::hash of the stored strings always was, so the buckets
+      // of existing images stay where they are
+
+      struct name_hash {
+        std::size_t operator()(const shared_string_t& x) const {
+          return boost::hash_range(x.begin(), x.end());
+        }
+
+        std::size_t operator()(const boost::string_view& x) const {
+          return boost::hash_range(x.begin(), x.end());
+        }
+      };
+
+      struct name_equal {
+        bool operator()(const shared_string_t& x, const shared_string_t& y) const {
+          return x == y;
+        }
+
+        bool operator()(const shared_string_t& x, const boost::string_view& y) const {
+          return boost::string_view(x.data(), x.size()) == y;
+        }
+
+        bool operator()(const boost::string_view& x, const shared_string_t& y) const {
+          return x == boost::string_view(y.data(), y.size());
+        }
+      };
+
       // partial (prefix) string comparison
       
       struct partial_string {
-        partial_string(const shared_string_t& str) : str(str) {}
-        shared_string_t str;
+        partial_string(const boost::string_view& str) : str(str) {}
+        boost::string_view str;
       };
       
       struct partial_string_comparator {
@@ -101,11 +162,11 @@ namespace sdm {
         }
 
         bool operator()(const shared_string_t& x,const partial_string& y) const {
-          return x.substr(0,y.str.size())<y.str;
+          return boost::string_view(x.data(), std::min(x.size(), y.str.size())) < y.str;
         }
 
         bool operator()(const partial_string& x,const shared_string_t& y) const {
-          return x.str<y.substr(0,x.str.size());
+          return x.str < boost::string_view(y.data(), std::min(y.size(), x.str.size()));
         }
       };
 
@@ -116,9 +177,13 @@ namespace sdm {
       typedef multi_index_container<
         symbol_t,
         indexed_by<
-          hashed_unique<BOOST_MULTI_INDEX_MEMBER(symbol_t, shared_string_t, _name)>,
-          ordered_unique<BOOST_MULTI_INDEX_MEMBER(symbol_t, shared_string_t, _name),
-                         partial_string_comparator>,
+          hashed_unique<BOOST_MULTI_INDEX_MEMBER(symbol_t, shared_string_t, _name),
+                        name_hash, name_equal>,
+          typename std::conditional<RankedNames,
+            ranked_unique<BOOST_MULTI_INDEX_MEMBER(symbol_t, shared_string_t, _name),
+                          partial_string_comparator>,
+            ordered_unique<BOOST_MULTI_INDEX_MEMBER(symbol_t, shared_string_t, _name),
+                           partial_string_comparator>>::type,
           random_access<>
           >, symbol_allocator_t
         > symbol_table_t;
@@ -134,7 +199,13 @@ namespace sdm {
       
       symbol_space(const std::string& s, segment_t& m)
         : name(s), segment(m), allocator(segment.get_segment_manager()) {
+        ensure_layout();
         index = segment.template find_or_construct<symbol_table_t>(name.c_str())(allocator);
+        hash_index = segment.template find<bucket_index_t>(mih_name().c_str()).first;
+        graph = segment.template find<hnsw_t>(hnsw_name().c_str()).first;
+        hashing = segment.template find<lsh_t>(lsh_name().c_str()).first;
+        inverted = segment.template find<ivf_t>(ivf_name().c_str()).first;
+        postings = segment.template find<postings_t>(postings_name().c_str()).first;
       }
 
       
@@ -176,7 +247,8 @@ namespace sdm {
         inserted_t either = index->insert(symbol_t(name.c_str(), basis, allocator, p));
         // index may prevent us 
         if (!either.second) return boost::none;
-        else return *either.first;
+        reindex(*either.first);
+        return *either.first;
       }
 
       
@@ -198,6 +270,7 @@ namespace sdm {
         // index may prevent us 
         if (!either.second) return boost::none;
         else {
+          reindex(*either.first);
           symbol_t& s = const_cast<symbol_t&>(*either.first);
           return s;
         }
@@ -217,13 +290,20 @@ namespace sdm {
         return symbols[i]; 
       }
 
-      /// more useful
+      /// more useful -- CAUTION writes must touch() the symbol
       
       inline symbol_t& symbol_at(std::size_t i) {
          symbol_by_index& symbols = index->template get<2>();
          return const_cast<symbol_t&>(symbols[i]);
       }
 
+      /// random access position of a symbol in this space
+
+      inline std::size_t position(const symbol_t& s) {
+        symbol_by_index& symbols = index->template get<2>();
+        return symbols.iterator_to(s) - symbols.begin();
+      }
+
       
       ////////////////////////////
       /// lookup symbol by name //
@@ -232,9 +312,9 @@ namespace sdm {
       typedef typename symbol_table_t::template nth_index<0>::type symbol_by_name;
 
       inline boost::optional<const symbol_t&>
-      get_symbol_by_name(const std::string& k) {
+      get_symbol_by_name(const boost::string_view k) {
         symbol_by_name& name_idx = index->template get<0>();
-        typename symbol_by_name::iterator i = name_idx.find(shared_string(k));
+        typename symbol_by_name::iterator i = name_idx.find(k);
         if (i == name_idx.end()) return boost::none;
         else return *i;
       }
@@ -244,12 +324,13 @@ namespace sdm {
          side-effect symbol state -- must not alter index state or
          memory layout the use case is to allow methods on symbol that
          are non const, for properties that are modified during
-         learning operations */
+         learning operations which should go through superpose() or
+         touch() the symbol to keep the search snapshot current */
       
       inline boost::optional<symbol_t&>
-      get_mutable_symbol_by_name(const std::string& k) {
+      get_mutable_symbol_by_name(const boost::string_view k) {
         symbol_by_name& name_idx = index->template get<0>();
-        typename symbol_by_name::iterator i = name_idx.find(shared_string(k));
+        typename symbol_by_name::iterator i = name_idx.find(k);
         if (i == name_idx.end()) return boost::none;
         symbol_t& s = const_cast<symbol_t&>(*i);
         return s;
@@ -265,9 +346,42 @@ namespace sdm {
       typedef typename symbol_by_prefix::iterator symbol_iterator;
 
       inline std::pair<symbol_iterator, symbol_iterator>
-      search(const std::string& k) {
+      search(const boost::string_view k) {
         symbol_by_prefix& name_idx = index->template get<1>();
-        return name_idx.equal_range(partial_string(shared_string(k)));
+        return name_idx.equal_range(partial_string(k));
+      }
+
+      /// number of symbols whose names start with k -- the difference of
+      /// the ranks of the ends of the range, so O(log n) however many
+
+      inline std::size_t count_prefix(const boost::string_view k) {
+        auto range = search(k);
+        return range_offset(range.first, range.second, std::integral_constant<bool, RankedNames>());
+      }
+
+      /// a page of at most n symbols whose names start with k from the
+      /// offset'th on -- the offset is a cursor into the range found by
+      /// rank, so a page deep into a large range costs no more than the
+      /// first
+
+      inline std::pair<symbol_iterator, symbol_iterator>
+      prefix_page(const boost::string_view k, const std::size_t offset, const std::size_t n) {
+        auto range = search(k);
+        const std::integral_constant<bool, RankedNames> ranked_names;
+        const std::size_t matches = range_offset(range.first, range.second, ranked_names);
+        const std::size_t a = std::min(offset, matches);
+        const std::size_t b = a + std::min(n, matches - a);
+        return std::make_pair(range_advance(range.first, a, ranked_names),
+                              range_advance(range.first, b, ranked_names));
+      }
+
+      /// random access positions of the symbols whose names start with
+      /// prefix in ascending order
+
+      inline void prefix_positions(const std::string& prefix, std::vector<std::size_t>& ids) {
+        auto range = search(prefix);
+        for (auto i = range.first; i != range.second; ++i) ids.push_back(position(*i));
+        std::sort(ids.begin(), ids.end());
       }
 
             
@@ -286,13 +400,449 @@ namespace sdm {
       inline const size_t entries() { return index->size(); }
       inline const std::string spacename() const { return name; }
 
+
+      ////////////////////////
+      /// learning updates ///
+      ////////////////////////
+
+      /// superpose source onto target symbol of this space
+
+      inline void superpose(symbol_t& target, const symbol_t& source, int rotations = 0) {
+        target.superpose(source, rotations);
+        cache.touch(position(target));
+        // only the bits of the source basis can have changed
+        if (postings) postings->file_basis(position(target), target.vector().words(),
+                                           source.basis().data(), source.basis().size(), rotations);
+        reindex(target, false);
+      }
+
+      /// superpose n sources (rotated if rotations is not null) onto
+      /// target as if one by one in order: their bases are folded into
+      /// set and clear masks applied in a single pass over the target
+
+      inline void superpose(symbol_t& target, const symbol_t* const* sources, const std::size_t n,
+                            const int* rotations = nullptr) {
+        typedef typename symbol_t::element_t element_t;
+        element_t set[symbol_t::n_elements] = {};
+        element_t clear[symbol_t::n_elements] = {};
+        for (std::size_t i = 0; i < n; ++i)
+          mask_basis(set, clear, symbol_t::dimensions, sources[i]->basis().data(), sources[i]->basis().size(),
+                     sources[i]->_dither, rotations ? rotations[i] : 0);
+
+        target.superpose(set, clear);
+        cache.touch(position(target));
+        if (postings) for (std::size_t i = 0; i < n; ++i)
+          postings->file_basis(position(target), target.vector().words(), sources[i]->basis().data(),
+                               sources[i]->basis().size(), rotations ? rotations[i] : 0);
+        reindex(target, false);
+      }
+
+      /// superpose each of n symbols with all the others as symmetric
+      /// pairwise superposes in order would: the masks of the bases
+      /// after each term are folded back to front once, those before it
+      /// carried forward, so every term costs one pass over its vector
+      /// rather than one per other term. A term repeated in the frame is
+      /// superposed with its own basis as pairwise; only with dithered
+      /// bases may its bits differ, as it is brought up to date a
+      /// position at a time rather than interleaved.
+
+      inline void bundle(symbol_t* const* terms, const std::size_t n) {
+        typedef typename symbol_t::element_t element_t;
+        const std::size_t w = symbol_t::n_elements;
+
+        // set and clear masks of terms i..n-1 at 2 * w * i
+        std::vector<element_t> after(2 * w * (n + 1), 0);
+        for (std::size_t i = n; i-- > 0;) {
+          element_t* set = &after[2 * w * i];
+          mask_basis(set, set + w, symbol_t::dimensions, terms[i]->basis().data(), terms[i]->basis().size(),
+                     terms[i]->_dither, 0);
+          compose_masks(set, set + w, set + 2 * w, set + 3 * w, w);
+        }
+
+        element_t before[2 * symbol_t::n_elements] = {};
+        element_t others[2 * symbol_t::n_elements];
+        for (std::size_t i = 0; i < n; ++i) {
+          std::copy(before, before + 2 * w, others);
+          compose_masks(others, others + w, &after[2 * w * (i + 1)], &after[2 * w * (i + 1) + w], w);
+
+          symbol_t& target = *terms[i];
+          target.superpose(others, others + w);
+          cache.touch(position(target));
+          if (postings) {
+            for (std::size_t j = 0; j < w; ++j) others[j] |= others[w + j];
+            postings->file_mask(position(target), target.vector().words(),
+                               reinterpret_cast<const kernels::word_t*>(others));
+          }
+          reindex(target, false);
+
+          mask_basis(before, before + w, symbol_t::dimensions, terms[i]->basis().data(), terms[i]->basis().size(),
+                     terms[i]->_dither, 0);
+        }
+      }
+
+      /// subtract source from target symbol of this space
+
+      inline void subtract(symbol_t& target, const symbol_t& source, int rotations = 0) {
+        target.subtract(source, rotations);
+        touch(target);
+      }
+
+      /// symbol vector was written via a mutable reference
+
+      inline void touch(const symbol_t& s) {
+        cache.touch(position(s));
+        reindex(s);
+      }
+
+
+      //////////////////////
+      /// search snapshot //
+      //////////////////////
+
+      /// dense matrix of all vectors brought up to date for a scan
+
+      inline const snapshot_t& snapshot() {
+        cache.refresh(*this);
+        return cache;
+      }
+
+      /// keep the snapshot in popcount order for range limited scans
+
+      inline void order_by_density(bool on = true) {
+        cache.order_by_density(on);
+      }
+
+
+      ////////////////////////////////
+      /// multi-index hashing index //
+      ////////////////////////////////
+
+      /// build a persistent multi-index hash of m substrings per vector
+      /// which is then maintained on every update -- answers false if the
+      /// vectors cannot be cut into m substrings
+
+      bool build_mih(const unsigned m) {
+        if (!mih::valid_tables(m, symbol_t::n_elements)) return false;
+
+        if (hash_index && hash_index->tables() != m) {
+          segment.template destroy<bucket_index_t>(mih_name().c_str());
+          hash_index = nullptr;
+        }
+
+        if (!hash_index) {
+          hash_index = segment.template construct<bucket_index_t>(mih_name().c_str())(m, allocator);
+          const std::size_t n = entries();
+          for (std::size_t i = 0; i < n; ++i)
+            mih::file(*hash_index, i, symbol_at(i).vector().words(), symbol_t::n_elements);
+        }
+        return true;
+      }
+
+      /// number of substrings hashed or 0 if there is no hash index
+
+      inline unsigned mih_tables() const {
+        return hash_index ? hash_index->tables() : 0;
+      }
+
+      /// positions of all symbols that may be within hamming radius of q
+      /// -- answers false if there is no hash index or it would visit more
+      /// than budget entries to answer
+
+      template <typename V>
+      inline bool mih_candidates(const V& q,
+                                 const std::size_t radius,
+                                 const std::size_t budget,
+                                 std::vector<std::size_t>& ids) const {
+        if (!hash_index) return false;
+        return mih::candidates(*hash_index, q.words(), symbol_t::n_elements, radius, budget, ids);
+      }
+
+
+
+      ////////////////////////////////////
+      /// approximate nearest neighbours //
+      ////////////////////////////////////
+
+      /// build a persistent hnsw graph with m links per node (2m at the
+      /// base level) which is then maintained on every update
+
+      bool build_hnsw(const unsigned m, const unsigned ef_construction) {
+        if (m < 2 || ef_construction < m) return false;
+        if (graph) {
+          segment.template destroy<hnsw_t>(hnsw_name().c_str());
+          graph = nullptr;
+        }
+        graph = segment.template construct<hnsw_t>(hnsw_name().c_str())(m, ef_construction, allocator);
+        const std::size_t n = entries();
+        for (std::size_t i = 0; i < n; ++i) graph->mark(i);
+        link_hnsw();
+        return true;
+      }
+
+      /// graph links per node or 0 if there is no graph
+
+      inline unsigned hnsw_degree() const {
+        return graph ? graph->degree() : 0;
+      }
+
+      /// positions of the ef approximate nearest symbols to q together with
+      /// any changed symbols still waiting to be linked -- answers false if
+      /// there is no graph
+
+      template <typename V>
+      bool hnsw_candidates(const V& q, const std::size_t ef, std::vector<std::size_t>& ids) {
+        if (!graph) return false;
+        const snapshot_t& rows = snapshot();
+        const kernels::popcount_kernels& kernel = kernels::dispatch();
+        std::vector<typename hnsw_t::scored_t> nearest;
+        graph->search([&](std::uint32_t a) {
+            return kernel.distance(q.words(), reinterpret_cast<const kernels::word_t*>(rows.row(a)),
+                                   symbol_t::n_elements);
+          }, ef, nearest);
+        for (auto& s: nearest) ids.push_back(s.second);
+        ids.insert(ids.end(), graph->backlog().begin(), graph->backlog().end());
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        return true;
+      }
+
+
+      /// build a persistent bit sampling lsh of l tables of k bits per
+      /// vector which is then maintained on every update -- answers false
+      /// if k bits cannot be sampled
+
+      bool build_lsh(const unsigned l, const unsigned k) {
+        if (!lsh_t::valid(l, k, symbol_t::n_elements)) return false;
+        if (hashing) {
+          segment.template destroy<lsh_t>(lsh_name().c_str());
+          hashing = nullptr;
+        }
+        hashing = segment.template construct<lsh_t>(lsh_name().c_str())(l, k, std::size_t(symbol_t::n_elements),
+                                                                       std::hash<std::string>()(name), allocator);
+        const std::size_t n = entries();
+        for (std::size_t i = 0; i < n; ++i) hashing->file(i, symbol_at(i).vector().words());
+        return true;
+      }
+
+      /// lsh tables or 0 if there is no lsh
+
+      inline unsigned lsh_tables() const {
+        return hashing ? hashing->tables() : 0;
+      }
+
+      /// positions of symbols hashed with q in some table probing up to
+      /// probes nearby keys per table -- answers false if there is no lsh
+      /// or it would visit more than budget entries to answer
+
+      template <typename V>
+      inline bool lsh_candidates(const V& q,
+                                 const std::size_t probes,
+                                 const std::size_t budget,
+                                 std::vector<std::size_t>& ids) const {
+        if (!hashing) return false;
+        return hashing->candidates(q.words(), probes, budget, ids);
+      }
+
+
+      /// (re)build a persistent inverted file of c partitions with rounds
+      /// of clustering -- new and changed symbols are then filed under
+      /// their nearest partition until the next build
+
+      bool build_ivf(const unsigned c, const unsigned rounds) {
+        if (c == 0 || rounds == 0) return false;
+        if (inverted) {
+          segment.template destroy<ivf_t>(ivf_name().c_str());
+          inverted = nullptr;
+        }
+        inverted = segment.template construct<ivf_t>(ivf_name().c_str())(c, std::size_t(symbol_t::n_elements),
+                                                                         allocator);
+        const snapshot_t& rows = snapshot();
+        inverted->build([&](std::size_t i) { return reinterpret_cast<const kernels::word_t*>(rows.row(i)); },
+                        rows.rows(), rounds);
+        return true;
+      }
+
+      /// ivf partitions or 0 if there is no inverted file
+
+      inline unsigned ivf_partitions() const {
+        return inverted ? inverted->partitions() : 0;
+      }
+
+      /// positions of symbols in the nprobe partitions nearest q together
+      /// with any waiting to be filed -- answers false if there is no
+      /// inverted file
+
+      template <typename V>
+      inline bool ivf_candidates(const V& q, const std::size_t nprobe, std::vector<std::size_t>& ids) const {
+        if (!inverted) return false;
+        inverted->candidates(q.words(), nprobe, ids);
+        return true;
+      }
+
+
+      //////////////////////////
+      /// bit posting lists ///
+      //////////////////////////
+
+      /// build persistent postings of the symbols with each bit set which
+      /// are then maintained on every update
+
+      bool build_postings() {
+        if (!postings) {
+          postings = segment.template construct<postings_t>(postings_name().c_str())(std::size_t(symbol_t::dimensions),
+                                                                                     allocator);
+          const std::size_t n = entries();
+          for (std::size_t i = 0; i < n; ++i) postings->file(i, symbol_at(i).vector().words());
+        }
+        return true;
+      }
+
+      inline bool has_postings() const { return postings != nullptr; }
+
+      /// positions of the symbols with at least least of the bits of a
+      /// basis rotated as by superpose set, with how many they have --
+      /// answers false if there are no postings
+
+      bool basis_overlap(const basis_view_t& basis,
+                         const int rotations,
+                         const std::size_t least,
+                         std::vector<std::pair<std::size_t, std::size_t>>& hits) const {
+        if (!postings) return false;
+        std::vector<std::size_t> bits;
+        for (auto b: basis) bits.push_back((b + rotations) % symbol_t::dimensions);
+        postings->overlap(bits.data(), bits.size(), least, [&hits](std::size_t id, std::size_t n) {
+            hits.push_back(std::make_pair(id, n));
+          });
+        return true;
+      }
+
+      
+    private:
+
+      /// search index object names -- hidden from the named spaces
+
+      inline std::string mih_name() const { return "_mih:" + name; }
+      inline std::string hnsw_name() const { return "_hnsw:" + name; }
+      inline std::string lsh_name() const { return "_lsh:" + name; }
+      inline std::string ivf_name() const { return "_ivf:" + name; }
+      inline std::string postings_name() const { return "_bits:" + name; }
+
+      /// bring the search indexes up to date with a new or changed symbol
       
-    private:    
+      inline void reindex(const symbol_t& s, const bool every_bit = true) {
+        if (postings && every_bit) postings->file(position(s), s.vector().words());
+        if (hash_index) mih::file(*hash_index, position(s), s.vector().words(), symbol_t::n_elements);
+        if (hashing) hashing->file(position(s), s.vector().words());
+        if (graph) {
+          graph->mark(position(s));
+          if (graph->backlog().size() >= index_batch) link_hnsw();
+        }
+        if (inverted) {
+          inverted->mark(position(s));
+          if (inverted->backlog().size() >= index_batch) {
+            const snapshot_t& rows = snapshot();
+            inverted->assign([&](std::size_t i) { return reinterpret_cast<const kernels::word_t*>(rows.row(i)); });
+          }
+        }
+      }
 
+      /// link symbols queued in the graph
+      
+      inline void link_hnsw() {
+        const snapshot_t& rows = snapshot();
+        const kernels::popcount_kernels& kernel = kernels::dispatch();
+        graph->link([&](std::uint32_t a, std::uint32_t b) {
+            return kernel.distance(reinterpret_cast<const kernels::word_t*>(rows.row(a)),
+                                   reinterpret_cast<const kernels::word_t*>(rows.row(b)),
+                                   symbol_t::n_elements);
+          });
+      }
+
+      // changed symbols queued before the graph is relinked or the
+      // inverted file refiled
+      static constexpr std::size_t index_batch = 256;
+
+      // distances and steps along the name order: by rank when ranked
+      // and by walking it otherwise
+
+      inline std::size_t range_offset(symbol_iterator a, symbol_iterator b, std::true_type) {
+        symbol_by_prefix& name_idx = index->template get<1>();
+        return name_idx.rank(b) - name_idx.rank(a);
+      }
+
+      inline std::size_t range_offset(symbol_iterator a, symbol_iterator b, std::false_type) {
+        return std::distance(a, b);
+      }
+
+      inline symbol_iterator range_advance(symbol_iterator a, std::size_t n, std::true_type) {
+        symbol_by_prefix& name_idx = index->template get<1>();
+        return name_idx.nth(name_idx.rank(a) + n);
+      }
+
+      inline symbol_iterator range_advance(symbol_iterator a, std::size_t n, std::false_type) {
+        return std::next(a, n);
+      }
+
+      /// the symbol layout an image was written with is recorded with the
+      /// first space so that a runtime built for another layout fails
+      /// here rather than misreading the heap; only a space about to be
+      /// created writes the tag so read only images are never touched.
+      /// Images predating the tag hold boxed symbols in unranked order.
+      
+      inline void ensure_layout() {
+        const char* tag = "_layout";
+        auto found = segment.template find<unsigned>(tag);
+        unsigned layout;
+        
+        if (found.first) {
+          layout = *found.first;
+        } else if (segment.get_num_named_objects() > 0) {
+          layout = SDM_LAYOUT_BOXED;
+        } else {
+          layout = image_layout();
+        }
+
+        if (layout != image_layout())
+          throw std::runtime_error("image symbol layout " + std::to_string(layout) +
+                                   " does not match runtime layout " +
+                                   std::to_string(image_layout()));
+
+        if (!found.first && !segment.template find<symbol_table_t>(name.c_str()).first)
+          segment.template construct<unsigned>(tag)(layout);
+      }
+      
       std::string          name; 
       symbol_table_t*      index;
       segment_t&           segment;
       void_allocator_t     allocator;
+      snapshot_t           cache;
+      bucket_index_t*      hash_index;
+      hnsw_t*              graph;
+      lsh_t*               hashing;
+      ivf_t*               inverted;
+      postings_t*          postings;
     };
+
+
+    /// copy all symbols of one space into another in index order, e.g. to
+    /// migrate an image between symbol layouts -- answers the number of
+    /// symbols copied which falls short if target already has any names
+    
+    template <typename source_space_t, typename target_space_t>
+    inline std::size_t copy_symbols(source_space_t& source, target_space_t& target) {
+      std::size_t copied = 0;
+      const std::size_t n = source.entries();
+      
+      for (std::size_t i = 0; i < n; ++i) {
+        const auto& s = source[i];
+        std::vector<unsigned> basis(s.basis().begin(), s.basis().end());
+        auto t = target.insert_mutable_symbol(s.name(), basis, s._dither);
+        if (t) {
+          t->assign(s.vector());
+          ++copied;
+        }
+      }
+      return copied;
+    }
   }
 }
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+
+
+namespace sdm {
+
+  namespace mms {
+
+    //////////////////////////////////////////////////////////////////////
+    /// topology metrics - measures of a candidate row against a target
+    ///                    for ranking topology scans
+    ///
+    /// with the popcounts tc and vc of target and row to hand every
+    /// metric is a function of their hamming distance d alone: the inner
+    /// product is (tc + vc - d) / 2 and the union (tc + vc + d) / 2. So
+    /// one bounded xor-popcount scores any of them and each metric turns
+    /// a bound on its value into a bound on d -- its reach -- that lets
+    /// the kernel abandon rows and the popcount difference rule them out.
+    ///
+    /// ascending metrics rank smallest first and are bounded from above,
+    /// the others rank largest first and are bounded from below. Metrics
+    /// by_distance reach the same distance whatever the popcounts so may
+    /// use radius limited candidate lists and popcount ordered walks
+    //////////////////////////////////////////////////////////////////////
+
+    /// 1 - d / D
+
+    struct similarity_metric {
+      static constexpr bool ascending = false;
+      static constexpr bool by_distance = true;
+
+      static inline double value(const std::size_t d, const std::size_t, const std::size_t, const double dims) {
+        return 1.0 - d / dims;
+      }
+
+      /// greatest value
+      static inline double most(const double) { return 1.0; }
+
+      /// one more allows for rounding as values are filtered exactly
+      static inline std::size_t reach(const double m, const std::size_t, const std::size_t, const double dims) {
+        return (m > 0) ? std::size_t((1.0 - m) * dims) + 1 : std::size_t(dims);
+      }
+    };
+
+
+    /// inner product over dimensions: (tc + vc - d) / 2 D
+
+    struct overlap_metric {
+      static constexpr bool ascending = false;
+      static constexpr bool by_distance = false;
+
+      static inline double value(const std::size_t d, const std::size_t tc, const std::size_t vc, const double dims) {
+        return (double(tc + vc) - d) / 2 / dims;
+      }
+
+      static inline double most(const double) { return 1.0; }
+
+      static inline std::size_t reach(const double m, const std::size_t tc, const std::size_t vc, const double dims) {
+        const double d = double(tc + vc) - 2 * m * dims;
+        return (m > 0) ? ((d < 0) ? 0 : std::size_t(d) + 1) : std::size_t(dims);
+      }
+    };
+
+
+    /// inner product over union: (tc + vc - d) / (tc + vc + d) -- two
+    /// empty vectors are alike
+
+    struct jaccard_metric {
+      static constexpr bool ascending = false;
+      static constexpr bool by_distance = false;
+
+      static inline double value(const std::size_t d, const std::size_t tc, const std::size_t vc, const double) {
+        return (tc + vc + d) ? (double(tc + vc) - d) / double(tc + vc + d) : 1.0;
+      }
+
+      static inline double most(const double) { return 1.0; }
+
+      static inline std::size_t reach(const double m, const std::size_t tc, const std::size_t vc, const double dims) {
+        return (m > 0) ? std::size_t((1.0 - m) * (tc + vc) / (1.0 + m)) + 1 : std::size_t(dims);
+      }
+    };
+
+
+    /// raw hamming distance in bits -- nearest first
+
+    struct hamming_metric {
+      static constexpr bool ascending = true;
+      static constexpr bool by_distance = true;
+
+      static inline double value(const std::size_t d, const std::size_t, const std::size_t, const double) {
+        return d;
+      }
+
+      static inline double most(const double dims) { return dims; }
+
+      static inline std::size_t reach(const double m, const std::size_t, const std::size_t, const double dims) {
+        return (m < 0) ? 0 : (m < dims) ? std::size_t(m) : std::size_t(dims);
+      }
+    };
+  }
+}
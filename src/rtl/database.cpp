@@ -58,6 +58,19 @@ namespace sdm {
   }
 
 
+  std::pair<sdm_status_t, sdm_handle_t>
+  database::ensure_handle(const std::string& sn,
+                          const std::string& vn,
+                          const sdm_prob_t p) noexcept {
+
+    auto symp = ensure_symbol(sn, vn, p);
+    if (sdm_error(symp.first)) return std::make_pair(symp.first, sdm_handle_t{0, 0});
+    
+    auto h = resolve(sn, vn);
+    return std::make_pair(sdm_error(h.first) ? h.first : symp.first, h.second);
+  }
+
+
   //////////////////////////////////////
   /// learning/transactional operations
   //////////////////////////////////////
@@ -127,26 +140,133 @@ namespace sdm {
     }
 
     // do the update to the target symbol
-    t->superpose(*s);
+    tsp.second->superpose(*t, *s);
     return state;
   }
 
 
-  /// batch superpose target with multiple symbols from source space
-  /*
+  /// superpose target with source by handle -- positions are stable
+  /// so unlike by name nothing can be inserted under us
+  
+  const sdm_status_t
+  database::superpose(const sdm_handle_t& th,
+                      const sdm_handle_t& sh,
+                      const int shifted) noexcept {
+
+    auto t = get_by_handle(th);
+    if (!t.first) return ESPACE;
+    if (!t.second) return ESYMBOL;
+
+    auto s = get_by_handle(sh);
+    if (!s.first) return ESPACE;
+    if (!s.second) return ESYMBOL;
+
+    t.first->superpose(*t.second, *s.second);
+    return AOLD;
+  }
+
+
+  /// batch superpose target with multiple symbols from source space:
+  /// the sources are resolved or created together, then the target,
+  /// and their bases applied to it in one pass
+  
   const sdm_status_t
   database::superpose(const std::string& ts,
                       const std::string& tn,
                       const std::string& ss,
-                      const std::vector<std::string&> sns,
-                      const std::vector<int> shifts,
-                      const bool refcount) noexcept {
+                      const std::vector<std::string>& sns,
+                      const std::vector<int>& shifts) noexcept {
+
+    if (!shifts.empty() && shifts.size() != sns.size()) return ERUNTIME;
+    sdm_status_t state = AOLD;
     
-    // XXX new approach to keep allocations to minimum places in code
-    //sdm_status_t sts = ensure_mutable_symbol
-    return EUNIMPLEMENTED;
+    auto tsp = ensure_space_by_name(ts);
+    if (sdm_error(tsp.first)) return tsp.first;
+    
+    auto ssp = ensure_space_by_name(ss);
+    if (sdm_error(ssp.first)) return ssp.first;
+
+    // sources are held by position as inserting later ones may
+    // invalidate references to earlier ones (see superpose above)
+    std::vector<std::size_t> at;
+    at.reserve(sns.size());
+    boost::optional<space::symbol_t&> t;
+    
+    try {
+      for (auto& sn: sns) {
+        auto s = ssp.second->get_symbol_by_name(sn);
+        if (!s) {
+          s = ssp.second->insert_symbol(sn, irand.shuffle());
+          if (!s) return EINDEX;
+          state = ANEW;
+        }
+        at.push_back(ssp.second->position(*s));
+      }
+      
+      t = tsp.second->get_mutable_symbol_by_name(tn);
+      if (!t) {
+        t = tsp.second->insert_mutable_symbol(tn, irand.shuffle());
+        if (!t) return EINDEX;
+        state = ANEW;
+      }
+      
+    } catch (boost::interprocess::bad_alloc& e) {
+      return EMEMORY;
+    }
+
+    std::vector<const space::symbol_t*> sources;
+    sources.reserve(at.size());
+    for (auto i: at) sources.push_back(&ssp.second->symbol_at(i));
+    
+    tsp.second->superpose(*t, sources.data(), sources.size(), shifts.empty() ? nullptr : shifts.data());
+    return state;
+  }
+
+
+  const sdm_status_t
+  database::superpose(const sdm_handle_t& th,
+                      const std::vector<sdm_handle_t>& shs,
+                      const std::vector<int>& shifts) noexcept {
+
+    if (!shifts.empty() && shifts.size() != shs.size()) return ERUNTIME;
+    
+    auto t = get_by_handle(th);
+    if (!t.first) return ESPACE;
+    if (!t.second) return ESYMBOL;
+
+    std::vector<const space::symbol_t*> sources;
+    sources.reserve(shs.size());
+    for (auto& sh: shs) {
+      auto s = get_by_handle(sh);
+      if (!s.first) return ESPACE;
+      if (!s.second) return ESYMBOL;
+      sources.push_back(s.second);
+    }
+    
+    t.first->superpose(*t.second, sources.data(), sources.size(), shifts.empty() ? nullptr : shifts.data());
+    return AOLD;
+  }
+
+
+  /// co-train a frame of terms with one another
+  
+  const sdm_status_t
+  database::bundle(const std::vector<sdm_handle_t>& ths) noexcept {
+
+    space* sp = nullptr;
+    std::vector<space::symbol_t*> terms;
+    terms.reserve(ths.size());
+    for (auto& th: ths) {
+      auto t = get_by_handle(th);
+      if (!t.first || (sp && t.first != sp)) return ESPACE;
+      if (!t.second) return ESYMBOL;
+      sp = t.first;
+      terms.push_back(t.second);
+    }
+
+    if (sp) sp->bundle(terms.data(), terms.size());
+    return AOLD;
   }
-  */
   
   /// remove source from target -- source and target must exist else this is a noop.
   
@@ -170,7 +290,7 @@ namespace sdm {
     if (!source_sym) return ESYMBOL;
 
     // effect
-    target_sym->subtract(*source_sym);
+    target_sp->subtract(*target_sym, *source_sym);
     return AOLD;
   }
 
@@ -186,6 +306,82 @@ namespace sdm {
   }
   
   
+  /// build persistent multi-index hash of space
+
+  const sdm_status_t
+  database::build_mih(const std::string& name, const unsigned tables) noexcept {
+    auto sp = get_space_by_name(name);
+    if (!sp) return ESPACE;
+    try {
+      return sp->build_mih(tables) ? AOK : EINDEX;
+    } catch (boost::interprocess::bad_alloc& e) {
+      return EMEMORY;
+    }
+  }
+  
+  
+  /// build persistent hnsw graph of space
+
+  const sdm_status_t
+  database::build_hnsw(const std::string& name,
+                       const unsigned m,
+                       const unsigned ef_construction) noexcept {
+    auto sp = get_space_by_name(name);
+    if (!sp) return ESPACE;
+    try {
+      return sp->build_hnsw(m, ef_construction) ? AOK : EINDEX;
+    } catch (boost::interprocess::bad_alloc& e) {
+      return EMEMORY;
+    }
+  }
+
+  
+  /// build persistent bit sampling lsh of space
+
+  const sdm_status_t
+  database::build_lsh(const std::string& name,
+                      const unsigned tables,
+                      const unsigned bits) noexcept {
+    auto sp = get_space_by_name(name);
+    if (!sp) return ESPACE;
+    try {
+      return sp->build_lsh(tables, bits) ? AOK : EINDEX;
+    } catch (boost::interprocess::bad_alloc& e) {
+      return EMEMORY;
+    }
+  }
+  
+  
+  /// build persistent bit postings of space
+
+  const sdm_status_t
+  database::build_postings(const std::string& name) noexcept {
+    auto sp = get_space_by_name(name);
+    if (!sp) return ESPACE;
+    try {
+      return sp->build_postings() ? AOK : EINDEX;
+    } catch (boost::interprocess::bad_alloc& e) {
+      return EMEMORY;
+    }
+  }
+  
+  
+  /// (re)build persistent inverted file of space
+
+  const sdm_status_t
+  database::build_ivf(const std::string& name,
+                      const unsigned partitions,
+                      const unsigned rounds) noexcept {
+    auto sp = get_space_by_name(name);
+    if (!sp) return ESPACE;
+    try {
+      return sp->build_ivf(partitions, rounds) ? AOK : EINDEX;
+    } catch (boost::interprocess::bad_alloc& e) {
+      return EMEMORY;
+    }
+  }
+  
+  
   // XXX inline allocators refactoring 
   
   //////////////////////////////////////////
@@ -63,6 +63,13 @@ namespace sdm {
                 const std::string& symbol_name,
                 const sdm_prob_t type = 1.0) noexcept;
 
+    /// handle on a named vector asserting it (and its space) if need be
+    
+    std::pair<sdm_status_t, sdm_handle_t>
+    ensure_handle(const std::string& space_name,
+                  const std::string& symbol_name,
+                  const sdm_prob_t type = 1.0) noexcept;
+
     
     /// add or superpose
     
@@ -71,14 +78,35 @@ namespace sdm {
               const std::string& ss, const std::string& sn,
               const int shift = 0) noexcept;
 
-    /// batch superpose several symbols from source space
-    /*
+    /// superpose by handles -- both symbols must exist
+    
+    const sdm_status_t
+    superpose(const sdm_handle_t& target, const sdm_handle_t& source,
+              const int shift = 0) noexcept;
+
+    /// batch superpose several symbols from source space onto the
+    /// target in one pass, asserting any that are missing -- shifts if
+    /// not empty rotate each source basis in turn
+    
     const sdm_status_t
     superpose(const std::string& ts, const std::string& tn,
-              const std::string& ss, const std::vector<std::string&> sns,
-              const std::vector<int> shifts,
-              const bool refcount = false) noexcept;
-    */
+              const std::string& ss, const std::vector<std::string>& sns,
+              const std::vector<int>& shifts = std::vector<int>()) noexcept;
+
+    /// and by handles -- all symbols must exist
+    
+    const sdm_status_t
+    superpose(const sdm_handle_t& target,
+              const std::vector<sdm_handle_t>& sources,
+              const std::vector<int>& shifts = std::vector<int>()) noexcept;
+
+    /// superpose each of a frame of symbols of one space with all the
+    /// others as symmetric unshifted pairwise superposes would, in a
+    /// pass per symbol -- all symbols must exist
+
+    const sdm_status_t
+    bundle(const std::vector<sdm_handle_t>& terms) noexcept;
+
     /// subtract
 
     const sdm_status_t
@@ -94,6 +122,42 @@ namespace sdm {
     bool
     destroy_space(const std::string&) noexcept;
 
+    /// build a multi-index hash of a space for exact small radius
+    /// topology queries -- vectors are cut into tables substrings
+    
+    const sdm_status_t
+    build_mih(const std::string& space_name, const unsigned tables = 32) noexcept;
+
+    /// build an hnsw graph of a space for approximate topology queries
+    /// with m links per node
+
+    const sdm_status_t
+    build_hnsw(const std::string& space_name,
+               const unsigned m = 16,
+               const unsigned ef_construction = 200) noexcept;
+
+    /// build a bit sampling lsh of a space for approximate topology
+    /// queries with tables of bits sampled bits each
+
+    const sdm_status_t
+    build_lsh(const std::string& space_name,
+              const unsigned tables = 16,
+              const unsigned bits = 32) noexcept;
+
+    /// build the bit postings of a space for elemental overlap queries
+
+    const sdm_status_t
+    build_postings(const std::string& space_name) noexcept;
+
+    /// (re)build an inverted file of a space for approximate topology
+    /// queries clustering it into partitions over rounds of k-means --
+    /// queries then scan effort out of partitions
+
+    const sdm_status_t
+    build_ivf(const std::string& space_name,
+              const unsigned partitions = 256,
+              const unsigned rounds = 8) noexcept;
+
     ///////////////////
     /// heap metrics //
     ///////////////////
@@ -29,7 +29,7 @@ namespace sdm {
                                         term_match& tm) {
 
         auto sl = search(prefix);
-        std::size_t matches = std::distance(sl.first, sl.second);
+        std::size_t matches = count_prefix(prefix);
 
         //term_match tm;
         //tm.terms.reserve(card_ub);
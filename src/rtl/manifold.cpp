@@ -1,8 +1,35 @@
 #include <iostream> // debugging only - TODO logging!
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
 #include "manifold.hpp"
+#include "../mms/nn_descent.hpp"
+#include "../mms/similarity_join.hpp"
+#include "../mms/topology_metrics.hpp"
 
 namespace sdm {
 
+  /// no bound on a metric
+  static const double unbounded = std::numeric_limits<double>::infinity();
+
+  /// name cub entries of a c topology by the mapped symbol names so
+  /// they stay good for as long as the image is open
+  static void name_topology(manifold::space* sp,
+                            const manifold::topology& topo,
+                            const sdm_size_t cub,
+                            sdm_topology_t top) {
+    std::size_t i = 0;
+    for (auto& nb: topo) {
+      auto sym = sp->get_symbol_by_name(nb.name);
+      top[i].p.name = sym->_name.c_str();
+      top[i].p.density = nb.density;
+      top[i].p.refcount = 0;
+      top[i++].metric = nb.metric;
+    }
+    if (i < cub) top[i].p.name = nullptr;
+  }
+
   ////////////////////////////////////////////
   /// construct manifold from read only image
   ////////////////////////////////////////////
@@ -37,14 +64,24 @@ namespace sdm {
     if (sp == nullptr) {
       return std::make_pair(ESPACE, 0);
     } else {
-      // non_const as density() function cannot be marked const!
-      auto v = sp->get_mutable_symbol_by_name(vn); 
+      auto v = sp->get_symbol_by_name(vn);
       if (v) return  std::make_pair(AOLD, v->density());
       else return std::make_pair(ESYMBOL, 0);
     }
   }
   
   
+  /// vector density by handle
+
+  std::pair<const sdm_status_t, const double>
+  manifold::density(const sdm_handle_t& h) noexcept {
+    auto s = get_by_handle(h);
+    if (!s.first) return std::make_pair(ESPACE, 0);
+    if (!s.second) return std::make_pair(ESYMBOL, 0);
+    return std::make_pair(AOLD, s.second->density());
+  }
+
+
   /// find symbols by prefix
   
   std::pair<sdm_status_t, manifold::symbol_list>
@@ -58,6 +95,56 @@ namespace sdm {
     }
   }
 
+
+  /// count symbols by prefix
+
+  std::pair<sdm_status_t, std::size_t>
+  manifold::prefix_count(const std::string& sn,
+                         const std::string& vp) noexcept {
+    auto sp = get_space_by_name(sn);
+    if (sp) return std::make_pair(AOK, sp->count_prefix(vp));
+    else return std::make_pair(ESPACE, 0);
+  }
+
+
+  /// page through symbols by prefix
+
+  std::pair<sdm_status_t, manifold::symbol_list>
+  manifold::prefix_page(const std::string& sn,
+                        const std::string& vp,
+                        std::size_t& cursor,
+                        const std::size_t n) noexcept {
+    auto sp = get_space_by_name(sn);
+    if (sp) {
+      auto page = sp->prefix_page(vp, cursor, n);
+      cursor += std::distance(page.first, page.second);
+      return std::make_pair(AOK, page);
+    } else {
+      manifold::space::symbol_iterator a, b;
+      return std::make_pair(ESPACE, std::make_pair(a, b));
+    }
+  }
+
+
+  sdm_status_t
+  manifold::prefix_page(const std::string& sn,
+                        const std::string& vp,
+                        std::size_t& cursor,
+                        const std::size_t n,
+                        sdm_geometry_t page) noexcept {
+    auto r = prefix_page(sn, vp, cursor, n);
+    if (sdm_error(r.first)) return r.first;
+
+    std::size_t i = 0;
+    for (auto s = r.second.first; s != r.second.second; ++s, ++i) {
+      page[i].name = s->_name.c_str();
+      page[i].density = s->density();
+      page[i].refcount = 0;
+    }
+    if (i < n) page[i].name = nullptr;
+    return AOK;
+  }
+
     
   /// compute semantic similarity between symbols
   
@@ -71,7 +158,7 @@ namespace sdm {
     auto target_sp = get_space_by_name(tvs);
     if (!target_sp) return std::make_pair(ESPACE, 0);
 
-    auto target_sym = target_sp->get_mutable_symbol_by_name(tvn);
+    auto target_sym = target_sp->get_symbol_by_name(tvn);
     if (!target_sym) return std::make_pair(ESYMBOL, 0);
 
     auto source_sp = get_space_by_name(svs);
@@ -84,6 +171,21 @@ namespace sdm {
   }
 
 
+  const std::pair<const sdm_status_t, const double>
+  manifold::similarity(const sdm_handle_t& th,
+                       const sdm_handle_t& sh) noexcept {
+    auto t = get_by_handle(th);
+    if (!t.first) return std::make_pair(ESPACE, 0);
+    if (!t.second) return std::make_pair(ESYMBOL, 0);
+
+    auto s = get_by_handle(sh);
+    if (!s.first) return std::make_pair(ESPACE, 0);
+    if (!s.second) return std::make_pair(ESYMBOL, 0);
+
+    return std::make_pair(AOLD, t.second->similarity(*s.second));
+  }
+
+
   /// compute semantic overlap between symbols -- we should have a
   
   const std::pair<const sdm_status_t, const double>
@@ -96,7 +198,7 @@ namespace sdm {
     auto target_sp = get_space_by_name(tvs);
     if (!target_sp) return std::make_pair(ESPACE, 0);
     
-    auto target_sym = target_sp->get_mutable_symbol_by_name(tvn);
+    auto target_sym = target_sp->get_symbol_by_name(tvn);
     if (!target_sym) return std::make_pair(ESYMBOL, 0);
 
     auto source_sp = get_space_by_name(svs);
@@ -108,6 +210,21 @@ namespace sdm {
     return std::make_pair(AOLD, target_sym->overlap(*source_sym));
   }
 
+
+  const std::pair<const sdm_status_t, const double>
+  manifold::overlap(const sdm_handle_t& th,
+                    const sdm_handle_t& sh) noexcept {
+    auto t = get_by_handle(th);
+    if (!t.first) return std::make_pair(ESPACE, 0);
+    if (!t.second) return std::make_pair(ESYMBOL, 0);
+
+    auto s = get_by_handle(sh);
+    if (!s.first) return std::make_pair(ESPACE, 0);
+    if (!s.second) return std::make_pair(ESYMBOL, 0);
+
+    return std::make_pair(AOLD, t.second->overlap(*s.second));
+  }
+
   
   //////////////////////////
   /// under construction
@@ -125,7 +242,7 @@ namespace sdm {
     std::size_t card = sp->entries();
 
     for (std::size_t i = 0; i < card; ++i) {
-      auto s = sp->symbol_at(i);
+      const auto& s = sp->symbol_at(i);
       g.push_back(point(s.name(), s.density()));
     }
 
@@ -143,10 +260,19 @@ namespace sdm {
     // get space
     auto sp = get_space_by_name(space);
     if (!sp) return ESPACE; // space not found
-    auto sym = sp->get_mutable_symbol_by_name(name);
+    auto sym = sp->get_symbol_by_name(name);
     if (!sym) return ESYMBOL;
-    auto v = sym->vector();
-    v.copyto(vector);
+    sym->vector().copyto(vector);
+    return AOK;
+  }
+
+  sdm_status_t
+  manifold::load_vector(const sdm_handle_t& h,
+                        sdm_vector_t vector) noexcept {
+    auto s = get_by_handle(h);
+    if (!s.first) return ESPACE;
+    if (!s.second) return ESYMBOL;
+    s.second->vector().copyto(vector);
     return AOK;
   }
 
@@ -156,9 +282,9 @@ namespace sdm {
                            sdm_sparse_t fp) {
     auto sp = get_space_by_name(space);
     if (!sp) return ESPACE; // space not found
-    auto sym = sp->get_mutable_symbol_by_name(name);
+    auto sym = sp->get_symbol_by_name(name);
     if (!sym) return ESYMBOL;
-    auto e = sym->basis();
+    const auto& e = sym->basis();
     #pragma unroll
     for (unsigned j=0; j < e.size(); ++j) {
       fp[j] = e[j];
@@ -167,6 +293,360 @@ namespace sdm {
   }
 
 
+  /// top-k scan shared by the get_topology variants: chunks of the space
+  /// snapshot keep bounded heaps of (index, metrics) and the sorted heaps
+  /// are merged so only the k winners ever copy their names. Only the
+  /// given candidates are scored if any; for metrics of distance alone
+  /// spaces with a hash index only score its candidates for small radii
+  /// and spaces in density order only scan the popcount range that
+  /// meets the bounds
+
+  template <typename M, typename V>
+  void manifold::scan_topology(manifold::space* sp,
+                               const V& target,
+                               topology& topo,
+                               const double dlb,
+                               const double dub,
+                               const double mlb,
+                               const double mub,
+                               const sdm_size_t cub,
+                               const std::vector<std::size_t>* only) {
+
+    // dense snapshot of the space vectors with their popcounts
+    const space::snapshot_t& snap = sp->snapshot();
+    const std::size_t m = snap.rows();
+    const std::size_t k = (cub < m) ? cub : m;
+    if (k == 0) return;
+
+    // with candidate popcounts to hand one xor-popcount pass gives
+    // density, similarity, overlap and the metric
+    const double dimensions = space::symbol_t::dimensions;
+    const std::size_t n = space::symbol_t::n_elements;
+    const mms::kernels::popcount_kernels& kernel = mms::kernels::dispatch();
+    const mms::kernels::word_t* tw = target.words();
+    const std::size_t tc = kernel.count(tw, n);
+
+    // score candidate row i into a bounded heap with the worst winner on
+    // top -- the distance is abandoned once it is beyond the reach of
+    // both the metric bound and a full heap's worst, and rows whose
+    // popcount alone puts them beyond it are never read
+    const double limit = M::ascending ? mub : mlb;
+    auto consider = [&](std::vector<ranked>& heap, const std::size_t i) {
+      const std::size_t vc = snap.count(i);
+      // apply d-filter before reading the row
+      if (vc / dimensions > dub || vc / dimensions < dlb) return;
+      std::size_t bound = M::reach(limit, tc, vc, dimensions);
+      if (heap.size() == k) bound = std::min(bound, M::reach(heap.front().metric, tc, vc, dimensions));
+      if ((vc > tc ? vc - tc : tc - vc) > bound) return;
+      const std::size_t d = kernel.distance_within(tw, reinterpret_cast<const mms::kernels::word_t*>(snap.row(i)), n, bound);
+      if (d > bound) return;
+      const double v = M::value(d, tc, vc, dimensions);
+      // apply p-filter
+      if (v < mlb || v > mub) return;
+      admit(heap, ranked{i, vc / dimensions, 1.0 - d / dimensions, (tc + vc - d) / 2 / dimensions,
+                         v, M::ascending ? -v : v}, k);
+    };
+
+    // candidate positions: the hash index can list the few symbols
+    // within the hamming radius implied by the bound when it is small
+    // (and answers false when its buckets are too full to beat a scan);
+    // otherwise every row or, in density order, only the rows whose
+    // popcount can meet the bounds -- hamming distance is at least the
+    // difference in popcounts. The +1s allow for rounding as every
+    // candidate is filtered exactly anyway
+    const std::size_t radius = M::reach(limit, tc, tc, dimensions);
+    std::vector<std::size_t> hashed;
+    const bool listing = only
+      || (M::by_distance && radius < dimensions && sp->mih_tables() > 0
+          && sp->mih_candidates(target, radius, m / 4, hashed));
+    const std::vector<std::size_t>& listed = only ? *only : hashed;
+
+    const space::snapshot_t::order_t& order = snap.by_density();
+    const bool ordered = M::by_distance && !listing && snap.density_ordered() && order.size() == m;
+    std::size_t first = 0, last = listing ? listed.size() : m;
+
+    if (ordered) {
+      const double lo = std::max(double(tc) - radius - 1, dlb * dimensions - 1);
+      const double hi = std::min(double(tc) + radius + 1, dub * dimensions + 1);
+      if (hi < 0 || hi < lo) return;
+      typedef space::snapshot_t::order_entry_t entry_t;
+      first = std::lower_bound(order.begin(), order.end(),
+                               entry_t(lo > 0 ? unsigned(lo) : 0, 0)) - order.begin();
+      last = std::upper_bound(order.begin(), order.end(),
+                              entry_t(unsigned(hi), m)) - order.begin();
+    }
+
+    // chunks of candidates each with its own heap
+    const std::size_t chunk = 4096;
+    const std::size_t nchunks = (last - first + chunk - 1) / chunk;
+    std::vector<std::vector<ranked>> heaps(nchunks);
+
+    auto scan = [&](std::size_t c) {
+      std::vector<ranked>& heap = heaps[c];
+      const std::size_t a = first + c * chunk;
+      const std::size_t b = (a + chunk < last) ? a + chunk : last;
+
+      if (!ordered) {
+        // abandoned rows are only partly read which costs the hardware
+        // prefetcher its stream, and listed rows are scattered and have
+        // none, so rows are fetched a few ahead instead
+        const std::size_t ahead = 4;
+        for (std::size_t p = a; p < b; ++p) {
+          if (p + ahead < b) {
+            const char* next = reinterpret_cast<const char*>(snap.row(listing ? listed[p + ahead] : p + ahead));
+            for (std::size_t line = 0; line < n * sizeof(mms::kernels::word_t); line += 64) __builtin_prefetch(next + line);
+          }
+          consider(heap, listing ? listed[p] : p);
+        }
+
+      } else {
+        // walk out from the target popcount, nearest count first, until
+        // no remaining count could beat the worst winner
+        std::size_t right = std::lower_bound(order.begin() + a, order.begin() + b,
+                                             space::snapshot_t::order_entry_t(tc, 0)) - order.begin();
+        std::size_t left = right;
+        while (left > a || right < b) {
+          const bool down = (right == b) || (left > a && tc - order[left - 1].first <= order[right].first - tc);
+          const std::size_t vc = down ? order[--left].first : order[right++].first;
+          const std::size_t gap = (vc > tc) ? vc - tc : tc - vc;
+          if (heap.size() == k && gap > M::reach(heap.front().metric, tc, vc, dimensions)) break;
+          consider(heap, down ? order[left].second : order[right - 1].second);
+        }
+      }
+      std::sort_heap(heap.begin(), heap.end());
+    };
+
+    #if HAVE_DISPATCH
+    dispatch_apply(nchunks, DISPATCH_APPLY_AUTO, ^(std::size_t c) {
+        scan(c);
+      });
+    
+    #elif HAVE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    for (std::size_t c=0; c < nchunks; ++c) scan(c);
+
+    #else
+    for (std::size_t c=0; c < nchunks; ++c) scan(c);
+    #endif
+
+    merge_topology(sp, heaps, k, topo,
+                   std::is_same<M, mms::overlap_metric>::value ? ::overlap
+                   : std::is_same<M, mms::jaccard_metric>::value ? ::jaccard
+                   : std::is_same<M, mms::hamming_metric>::value ? ::hamming
+                   : ::similarity);
+  }
+
+
+  /// runtime choice of metric for the scan
+
+  template <typename V>
+  void manifold::scan_topology(manifold::space* sp,
+                               const V& target,
+                               topology& topo,
+                               const sdm_metric_t metric,
+                               const double dlb,
+                               const double dub,
+                               const double mlb,
+                               const double mub,
+                               const sdm_size_t cub) {
+    switch (metric) {
+    case ::overlap:
+      scan_topology<mms::overlap_metric>(sp, target, topo, dlb, dub, mlb, mub, cub);
+      break;
+    case ::jaccard:
+      scan_topology<mms::jaccard_metric>(sp, target, topo, dlb, dub, mlb, mub, cub);
+      break;
+    case ::hamming:
+      scan_topology<mms::hamming_metric>(sp, target, topo, dlb, dub, mlb, mub, cub);
+      break;
+    default:
+      scan_topology<mms::similarity_metric>(sp, target, topo, dlb, dub, mlb, mub, cub);
+    }
+  }
+
+
+  /// counting scan: the same bounds and pruning as scan_topology but
+  /// chunks only tally rows -- into per chunk histograms when wanted --
+  /// and the tallies are summed
+
+  template <typename M, typename V>
+  void manifold::count_scan(manifold::space* sp,
+                            const V& target,
+                            const double dlb,
+                            const double dub,
+                            const double mlb,
+                            const double mub,
+                            std::size_t& count,
+                            std::vector<std::size_t>& histogram) {
+
+    const space::snapshot_t& snap = sp->snapshot();
+    const std::size_t m = snap.rows();
+    const std::size_t buckets = histogram.size();
+    count = 0;
+    std::fill(histogram.begin(), histogram.end(), 0);
+    if (m == 0) return;
+
+    const double dimensions = space::symbol_t::dimensions;
+    const std::size_t n = space::symbol_t::n_elements;
+    const mms::kernels::popcount_kernels& kernel = mms::kernels::dispatch();
+    const mms::kernels::word_t* tw = target.words();
+    const std::size_t tc = kernel.count(tw, n);
+    const double limit = M::ascending ? mub : mlb;
+
+    // buckets split the bounds clipped to the values the metric takes
+    const double lo = std::max(mlb, 0.0);
+    const double width = buckets ? (std::min(mub, M::most(dimensions)) - lo) / buckets : 0;
+
+    // in density order only the popcount window that can meet the
+    // bounds is read
+    const space::snapshot_t::order_t& order = snap.by_density();
+    const bool ordered = M::by_distance && snap.density_ordered() && order.size() == m;
+    std::size_t first = 0, last = m;
+
+    if (ordered) {
+      const std::size_t radius = M::reach(limit, tc, tc, dimensions);
+      const double a = std::max(double(tc) - radius - 1, dlb * dimensions - 1);
+      const double b = std::min(double(tc) + radius + 1, dub * dimensions + 1);
+      if (b < 0 || b < a) return;
+      typedef space::snapshot_t::order_entry_t entry_t;
+      first = std::lower_bound(order.begin(), order.end(),
+                               entry_t(a > 0 ? unsigned(a) : 0, 0)) - order.begin();
+      last = std::upper_bound(order.begin(), order.end(),
+                              entry_t(unsigned(b), m)) - order.begin();
+    }
+
+    const std::size_t chunk = 4096;
+    const std::size_t nchunks = (last - first + chunk - 1) / chunk;
+    std::vector<std::size_t> counts(nchunks);
+    std::vector<std::vector<std::size_t>> tallies(nchunks, std::vector<std::size_t>(buckets));
+
+    auto scan = [&](std::size_t c) {
+      const std::size_t a = first + c * chunk;
+      const std::size_t b = (a + chunk < last) ? a + chunk : last;
+      std::vector<std::size_t>& tally = tallies[c];
+
+      for (std::size_t p = a; p < b; ++p) {
+        const std::size_t i = ordered ? order[p].second : p;
+        const std::size_t vc = snap.count(i);
+        if (vc / dimensions > dub || vc / dimensions < dlb) continue;
+        const std::size_t bound = M::reach(limit, tc, vc, dimensions);
+        if ((vc > tc ? vc - tc : tc - vc) > bound) continue;
+        const std::size_t d = kernel.distance_within(tw, reinterpret_cast<const mms::kernels::word_t*>(snap.row(i)), n, bound);
+        if (d > bound) continue;
+        const double v = M::value(d, tc, vc, dimensions);
+        if (v < mlb || v > mub) continue;
+        ++counts[c];
+        if (buckets) {
+          const std::size_t at = (width > 0) ? std::size_t((v - lo) / width) : 0;
+          ++tally[std::min(at, buckets - 1)];
+        }
+      }
+    };
+
+    #if HAVE_DISPATCH
+    dispatch_apply(nchunks, DISPATCH_APPLY_AUTO, ^(std::size_t c) {
+        scan(c);
+      });
+
+    #elif HAVE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    for (std::size_t c=0; c < nchunks; ++c) scan(c);
+
+    #else
+    for (std::size_t c=0; c < nchunks; ++c) scan(c);
+    #endif
+
+    for (std::size_t c = 0; c < nchunks; ++c) {
+      count += counts[c];
+      for (std::size_t h = 0; h < buckets; ++h) histogram[h] += tallies[c][h];
+    }
+  }
+
+
+  /// runtime choice of metric for the count
+
+  template <typename V>
+  void manifold::count_scan(manifold::space* sp,
+                            const V& target,
+                            const sdm_metric_t metric,
+                            const double dlb,
+                            const double dub,
+                            const double mlb,
+                            const double mub,
+                            std::size_t& count,
+                            std::vector<std::size_t>& histogram) {
+    switch (metric) {
+    case ::overlap:
+      count_scan<mms::overlap_metric>(sp, target, dlb, dub, mlb, mub, count, histogram);
+      break;
+    case ::jaccard:
+      count_scan<mms::jaccard_metric>(sp, target, dlb, dub, mlb, mub, count, histogram);
+      break;
+    case ::hamming:
+      count_scan<mms::hamming_metric>(sp, target, dlb, dub, mlb, mub, count, histogram);
+      break;
+    default:
+      count_scan<mms::similarity_metric>(sp, target, dlb, dub, mlb, mub, count, histogram);
+    }
+  }
+
+
+  /// most hamming distance a row can be from a target and still reach
+  /// similarity s -- one more allows for rounding as callers filter on
+  /// the exact similarity
+
+  std::size_t manifold::reach(const double s) {
+    const double dimensions = space::symbol_t::dimensions;
+    return (s > 0) ? std::size_t((1.0 - s) * dimensions) + 1 : std::size_t(dimensions);
+  }
+
+
+  /// bounded heap of the k best with the worst on top
+
+  void manifold::admit(std::vector<ranked>& heap, const ranked& r, const std::size_t k) {
+    if (heap.size() < k) {
+      heap.push_back(r);
+      std::push_heap(heap.begin(), heap.end());
+    } else if (r < heap.front()) {
+      std::pop_heap(heap.begin(), heap.end());
+      heap.back() = r;
+      std::push_heap(heap.begin(), heap.end());
+    }
+  }
+
+
+  /// k-way merge of sorted chunk winners naming the best k
+
+  void manifold::merge_topology(space* sp,
+                                const std::vector<std::vector<ranked>>& heaps,
+                                const std::size_t k,
+                                topology& topo,
+                                const sdm_metric_t metric) {
+    const std::size_t nchunks = heaps.size();
+
+    // k-way merge of the sorted chunk heaps on their current heads
+    typedef std::pair<ranked, std::size_t> head_t;
+    auto worse = [](const head_t& a, const head_t& b) { return b.first < a.first; };
+    std::vector<head_t> heads;
+    std::vector<std::size_t> next(nchunks, 1);
+    for (std::size_t c=0; c < nchunks; ++c)
+      if (!heaps[c].empty()) heads.push_back(std::make_pair(heaps[c][0], c));
+    std::make_heap(heads.begin(), heads.end(), worse);
+
+    topo.reserve(topo.size() + k);
+    for (std::size_t n=0; n < k && !heads.empty(); ++n) {
+      std::pop_heap(heads.begin(), heads.end(), worse);
+      const ranked& r = heads.back().first;
+      topo.push_back(neighbour(sp->symbol_at(r.index).name(), r.density, r.similarity, r.overlap, r.metric, metric));
+      const std::size_t c = heads.back().second;
+      if (next[c] < heaps[c].size()) {
+        heads.back().first = heaps[c][next[c]++];
+        std::push_heap(heads.begin(), heads.end(), worse);
+      } else heads.pop_back();
+    }
+  }
+
+
   // no need to be copying vectordata around for this.
   
   sdm_status_t
@@ -182,133 +662,753 @@ namespace sdm {
     manifold::space* tsp = get_space_by_name(targetspace);
     if (!tsp) return ESPACE; // space not found
 
-    // obtain current cardinality of the space
-    std::size_t m = tsp->entries();
-
     // get source space
-    manifold::space* ssp = get_space_by_name(targetspace);
+    manifold::space* ssp = get_space_by_name(sourcespace);
     if (!ssp) return ESPACE; // space not found
     
-    auto sym = ssp->get_mutable_symbol_by_name(vectorname);
+    auto sym = ssp->get_symbol_by_name(vectorname);
     if (!sym) return ESYMBOL;
-    
-    auto target = sym->vector();
-    
-    // create an array for work!
-    auto work = new double[m*3];
 
+    // views straight onto the mapped words -- the scan allocates nothing
+    scan_topology<mms::similarity_metric>(tsp, sym->vector(), topo, 0.0, dub, mlb, unbounded, cub);
+    return AOK;
+  }
+  
 
-    #if HAVE_DISPATCH
-    dispatch_apply(m, DISPATCH_APPLY_AUTO, ^(std::size_t i) {
-        auto v = ssp->symbol_at(i).vector();
-        work[i*3] = v.density();
-        work[i*3+1] = target.similarity(v);
-        work[i*3+2] = target.overlap(v);
-      });
-    
-    #elif HAVE_OPENMP
-    #pragma omp parallel for 
-    for (std::size_t i=0; i < m; ++i) {
-      auto v = ssp->symbol_at(i).vector();
-      work[i*3] = v.density();
-      work[i*3+1] = target.similarity(v);
-      work[i*3+2] = target.overlap(v);
+  sdm_status_t
+  manifold::get_topology(const std::string& targetspace,
+                         const sdm_vector_t& vector,
+                         topology& topo,
+                         const double dub,
+                         const double mlb,
+                         const sdm_size_t cub) {
+
+    // step 1 get the space 
+    manifold::space* sp = get_space_by_name(targetspace);
+    if (!sp) return ESPACE; // space not found
+
+    // create a bitvector from input yet another copy! 
+    svector target(vector);
+
+    scan_topology<mms::similarity_metric>(sp, target, topo, 0.0, dub, mlb, unbounded, cub);
+    return AOK;
+  }
+
+
+  /// topology within a namespace: the prefix's range of the ordered
+  /// name index gives the candidates, scored in parallel chunks as any
+  /// candidate list -- the scan is proportional to the namespace
+
+  sdm_status_t
+  manifold::get_topology(const std::string& targetspace,
+                         const std::string& sourcespace,
+                         const std::string& vectorname,
+                         const std::string& prefix,
+                         topology& topo,
+                         const double dub,
+                         const double mlb,
+                         const sdm_size_t cub) {
+
+    manifold::space* tsp = get_space_by_name(targetspace);
+    if (!tsp) return ESPACE; // space not found
+
+    manifold::space* ssp = get_space_by_name(sourcespace);
+    if (!ssp) return ESPACE; // space not found
+
+    auto sym = ssp->get_symbol_by_name(vectorname);
+    if (!sym) return ESYMBOL;
+
+    if (prefix.empty()) {
+      scan_topology<mms::similarity_metric>(tsp, sym->vector(), topo, 0.0, dub, mlb, unbounded, cub);
+    } else {
+      std::vector<std::size_t> candidates;
+      tsp->prefix_positions(prefix, candidates);
+      if (!candidates.empty())
+        scan_topology<mms::similarity_metric>(tsp, sym->vector(), topo, 0.0, dub, mlb, unbounded, cub, &candidates);
     }
-    #endif
+    return AOK;
+  }
 
-        
-    // filter work array on density and similarity bounds
-    for (std::size_t i=0; i < m; ++i) {
-      double r = work[i*3];
-      double s = work[i*3+1];
-      double o = work[i*3+2];
-      // apply p-d-filter
-      if (r <= dub && s >= mlb) {
-        neighbour n(ssp->symbol_at(i).name(), r, s, o);
-        topo.push_back(n);
-      }
+
+  sdm_status_t
+  manifold::get_topology(const std::string& targetspace,
+                         const sdm_vector_t& vector,
+                         const std::string& prefix,
+                         topology& topo,
+                         const double dub,
+                         const double mlb,
+                         const sdm_size_t cub) {
+
+    manifold::space* sp = get_space_by_name(targetspace);
+    if (!sp) return ESPACE; // space not found
+
+    svector target(vector);
+    if (prefix.empty()) {
+      scan_topology<mms::similarity_metric>(sp, target, topo, 0.0, dub, mlb, unbounded, cub);
+    } else {
+      std::vector<std::size_t> candidates;
+      sp->prefix_positions(prefix, candidates);
+      if (!candidates.empty())
+        scan_topology<mms::similarity_metric>(sp, target, topo, 0.0, dub, mlb, unbounded, cub, &candidates);
     }
+    return AOK;
+  }
 
-    delete[] work;
-    
-    // sort the scores in similarity order
-    sort(topo.begin(), topo.end());
-    const std::size_t ns = topo.size();
 
-    // chop off uneeded tail
-    topo.erase(topo.begin() + ((cub < ns) ? cub : ns), topo.end());
+  /// topology by metric with both bounds on density and metric
+
+  sdm_status_t
+  manifold::get_topology(const std::string& targetspace,
+                         const sdm_vector_t& vector,
+                         const sdm_size_t cub,
+                         const sdm_metric_t metric,
+                         const double dlb,
+                         const double dub,
+                         const double mlb,
+                         const double mub,
+                         topology& topo) {
+
+    manifold::space* sp = get_space_by_name(targetspace);
+    if (!sp) return ESPACE; // space not found
+
+    svector target(vector);
+    scan_topology(sp, target, topo, metric, dlb, dub, mlb, mub, cub);
     return AOK;
-    
-    
-    return EUNIMPLEMENTED;
   }
-  
-  // XXX let's get this working FFS!
+
+
+  sdm_status_t
+  manifold::get_topology(const std::string& targetspace,
+                         const std::string& sourcespace,
+                         const std::string& vectorname,
+                         const sdm_size_t cub,
+                         const sdm_metric_t metric,
+                         const double dlb,
+                         const double dub,
+                         const double mlb,
+                         const double mub,
+                         topology& topo) {
+
+    manifold::space* tsp = get_space_by_name(targetspace);
+    if (!tsp) return ESPACE; // space not found
+
+    manifold::space* ssp = get_space_by_name(sourcespace);
+    if (!ssp) return ESPACE; // space not found
+
+    auto sym = ssp->get_symbol_by_name(vectorname);
+    if (!sym) return ESYMBOL;
+
+    scan_topology(tsp, sym->vector(), topo, metric, dlb, dub, mlb, mub, cub);
+    return AOK;
+  }
+
+
+  /// c topology: names point into the mapped symbols so stay good for
+  /// as long as the image is open
+
   sdm_status_t
   manifold::get_topology(const std::string& targetspace,
                          const sdm_vector_t& vector,
+                         const sdm_size_t cub,
+                         const sdm_metric_t metric,
+                         const double dlb,
+                         const double dub,
+                         const double mlb,
+                         const double mub,
+                         sdm_topology_t top) {
+
+    manifold::space* sp = get_space_by_name(targetspace);
+    if (!sp) return ESPACE; // space not found
+
+    topology topo;
+    svector target(vector);
+    scan_topology(sp, target, topo, metric, dlb, dub, mlb, mub, cub);
+    name_topology(sp, topo, cub, top);
+    return AOK;
+  }
+
+
+  /// topologies by handle
+
+  sdm_status_t
+  manifold::get_topology(const unsigned targetspace,
+                         const sdm_handle_t& source,
+                         const sdm_size_t cub,
+                         const sdm_metric_t metric,
+                         const double dlb,
+                         const double dub,
+                         const double mlb,
+                         const double mub,
+                         topology& topo) {
+
+    manifold::space* tsp = get_space_by_id(targetspace);
+    if (!tsp) return ESPACE;
+
+    auto s = get_by_handle(source);
+    if (!s.first) return ESPACE;
+    if (!s.second) return ESYMBOL;
+
+    scan_topology(tsp, s.second->vector(), topo, metric, dlb, dub, mlb, mub, cub);
+    return AOK;
+  }
+
+
+  sdm_status_t
+  manifold::get_topology(const unsigned targetspace,
+                         const sdm_handle_t& source,
+                         const sdm_size_t cub,
+                         const sdm_metric_t metric,
+                         const double dlb,
+                         const double dub,
+                         const double mlb,
+                         const double mub,
+                         sdm_topology_t top) {
+
+    topology topo;
+    sdm_status_t sts = get_topology(targetspace, source, cub, metric, dlb, dub, mlb, mub, topo);
+    if (sdm_error(sts)) return sts;
+    name_topology(get_space_by_id(targetspace), topo, cub, top);
+    return AOK;
+  }
+
+
+  sdm_status_t
+  manifold::get_topology(const unsigned targetspace,
+                         const sdm_handle_t& source,
                          topology& topo,
                          const double dub,
                          const double mlb,
                          const sdm_size_t cub) {
 
-    // step 1 get the space 
+    manifold::space* tsp = get_space_by_id(targetspace);
+    if (!tsp) return ESPACE;
+
+    auto s = get_by_handle(source);
+    if (!s.first) return ESPACE;
+    if (!s.second) return ESYMBOL;
+
+    scan_topology<mms::similarity_metric>(tsp, s.second->vector(), topo, 0.0, dub, mlb, unbounded, cub);
+    return AOK;
+  }
+
+
+  /// level set cardinality and histogram
+
+  sdm_status_t
+  manifold::count_topology(const std::string& targetspace,
+                           const sdm_vector_t& vector,
+                           const sdm_metric_t metric,
+                           const double dlb,
+                           const double dub,
+                           const double mlb,
+                           const double mub,
+                           std::size_t& count,
+                           std::vector<std::size_t>& histogram) {
+
     manifold::space* sp = get_space_by_name(targetspace);
     if (!sp) return ESPACE; // space not found
 
-    // obtain current cardinality of the space
-    std::size_t m = sp->entries();
-
-    // create a bitvector from input yet another copy! 
     svector target(vector);
-    
-    // create an array for work!
-    auto work = new double[m*3];
+    count_scan(sp, target, metric, dlb, dub, mlb, mub, count, histogram);
+    return AOK;
+  }
 
 
+  sdm_status_t
+  manifold::count_topology(const std::string& targetspace,
+                           const std::string& sourcespace,
+                           const std::string& vectorname,
+                           const sdm_metric_t metric,
+                           const double dlb,
+                           const double dub,
+                           const double mlb,
+                           const double mub,
+                           std::size_t& count,
+                           std::vector<std::size_t>& histogram) {
+
+    manifold::space* tsp = get_space_by_name(targetspace);
+    if (!tsp) return ESPACE; // space not found
+
+    manifold::space* ssp = get_space_by_name(sourcespace);
+    if (!ssp) return ESPACE; // space not found
+
+    auto sym = ssp->get_symbol_by_name(vectorname);
+    if (!sym) return ESYMBOL;
+
+    count_scan(tsp, sym->vector(), metric, dlb, dub, mlb, mub, count, histogram);
+    return AOK;
+  }
+
+
+  /// one pass topology of many vectors
+
+  sdm_status_t
+  manifold::get_topology_batch(const std::string& targetspace,
+                               const sdm_vector_t* vectors,
+                               const std::size_t n,
+                               std::vector<topology>& topos,
+                               const double dub,
+                               const double mlb,
+                               const sdm_size_t cub) {
+
+    manifold::space* sp = get_space_by_name(targetspace);
+    if (!sp) return ESPACE;
+
+    std::vector<const mms::kernels::word_t*> targets(n);
+    for (std::size_t i = 0; i < n; ++i) targets[i] = reinterpret_cast<const mms::kernels::word_t*>(vectors[i]);
+
+    scan_topology_batch(sp, targets, topos, dub, mlb, cub);
+    return AOK;
+  }
+
+
+  sdm_status_t
+  manifold::get_topology_batch(const std::string& targetspace,
+                               const std::string& sourcespace,
+                               const std::vector<std::string>& names,
+                               std::vector<topology>& topos,
+                               const double dub,
+                               const double mlb,
+                               const sdm_size_t cub) {
+
+    manifold::space* tsp = get_space_by_name(targetspace);
+    if (!tsp) return ESPACE;
+
+    manifold::space* ssp = get_space_by_name(sourcespace);
+    if (!ssp) return ESPACE;
+
+    // views straight onto the mapped words
+    std::vector<const mms::kernels::word_t*> targets;
+    targets.reserve(names.size());
+    for (auto& name: names) {
+      auto sym = ssp->get_symbol_by_name(name);
+      if (!sym) return ESYMBOL;
+      targets.push_back(sym->vector().words());
+    }
+
+    scan_topology_batch(tsp, targets, topos, dub, mlb, cub);
+    return AOK;
+  }
+
+
+  /// top-k of many targets from a single pass over the space: each chunk
+  /// of rows is walked in blocks small enough to stay in cache and every
+  /// block is scored against a tile of targets at a time, so the space
+  /// is read once rather than once per target
+
+  void manifold::scan_topology_batch(manifold::space* sp,
+                                     const std::vector<const mms::kernels::word_t*>& targets,
+                                     std::vector<topology>& topos,
+                                     const double dub,
+                                     const double mlb,
+                                     const sdm_size_t cub) {
+
+    const std::size_t nq = targets.size();
+    topos.assign(nq, topology());
+
+    const space::snapshot_t& snap = sp->snapshot();
+    const std::size_t m = snap.rows();
+    const std::size_t k = (cub < m) ? cub : m;
+    if (k == 0 || nq == 0) return;
+
+    const double dimensions = space::symbol_t::dimensions;
+    const std::size_t n = space::symbol_t::n_elements;
+    const mms::kernels::popcount_kernels& kernel = mms::kernels::dispatch();
+
+    std::vector<std::size_t> tc(nq);
+    for (std::size_t q = 0; q < nq; ++q) tc[q] = kernel.count(targets[q], n);
+    const std::size_t radius = reach(mlb);
+
+    // 4096 row chunks of 64 row blocks (128k) against 16 target tiles (32k)
+    const std::size_t chunk = 4096, block = 64, tile = 16;
+    const std::size_t nchunks = (m + chunk - 1) / chunk;
+    std::vector<std::vector<std::vector<ranked>>> heaps(nq, std::vector<std::vector<ranked>>(nchunks));
+
+    auto scan = [&](std::size_t c) {
+      const std::size_t a = c * chunk;
+      const std::size_t b = (a + chunk < m) ? a + chunk : m;
+
+      for (std::size_t r = a; r < b; r += block) {
+        const std::size_t re = (r + block < b) ? r + block : b;
+        for (std::size_t t = 0; t < nq; t += tile) {
+          const std::size_t te = (t + tile < nq) ? t + tile : nq;
+          for (std::size_t q = t; q < te; ++q) {
+            std::vector<ranked>& heap = heaps[q][c];
+            for (std::size_t i = r; i < re; ++i) {
+              const std::size_t vc = snap.count(i);
+              // apply d-filter before reading the row
+              if (vc / dimensions > dub) continue;
+              // abandoned beyond both mlb and a full heap's worst
+              const std::size_t bound = (heap.size() == k) ? std::min(radius, reach(heap.front().similarity)) : radius;
+              const std::size_t d = kernel.distance_within(targets[q], reinterpret_cast<const mms::kernels::word_t*>(snap.row(i)), n, bound);
+              if (d > bound) continue;
+              const double similarity = 1.0 - d / dimensions;
+              // apply p-filter
+              if (similarity < mlb) continue;
+              ranked s{i, vc / dimensions, similarity, (tc[q] + vc - d) / 2 / dimensions, similarity, similarity};
+              admit(heap, s, k);
+            }
+          }
+        }
+      }
+      for (std::size_t q = 0; q < nq; ++q) std::sort_heap(heaps[q][c].begin(), heaps[q][c].end());
+    };
+
     #if HAVE_DISPATCH
-    dispatch_apply(m, DISPATCH_APPLY_AUTO, ^(std::size_t i) {
-        auto v = sp->symbol_at(i).vector();
-        work[i*3] = v.density();
-        work[i*3+1] = target.similarity(v);
-        work[i*3+2] = target.overlap(v);
+    dispatch_apply(nchunks, DISPATCH_APPLY_AUTO, ^(std::size_t c) {
+        scan(c);
       });
     
     #elif HAVE_OPENMP
-    #pragma omp parallel for 
-    for (std::size_t i=0; i < m; ++i) {
-      auto v = sp->symbol_at(i).vector();
-      work[i*3] = v.density();
-      work[i*3+1] = target.similarity(v);
-      work[i*3+2] = target.overlap(v);
+    #pragma omp parallel for schedule(dynamic)
+    for (std::size_t c=0; c < nchunks; ++c) scan(c);
+
+    #else
+    for (std::size_t c=0; c < nchunks; ++c) scan(c);
+    #endif
+
+    for (std::size_t q = 0; q < nq; ++q) merge_topology(sp, heaps[q], k, topos[q]);
+  }
+  
+
+  /// all pairs above mlb from one triangle of tiled block pairs -- each
+  /// unordered pair is scored once and emitted both ways round, so the
+  /// density bound applies to the second symbol as in get_topology
+
+  sdm_status_t
+  manifold::similarity_join(const std::string& space_name,
+                            std::vector<std::vector<join_entry>>& buffers,
+                            const double dub,
+                            const double mlb) {
+
+    manifold::space* sp = get_space_by_name(space_name);
+    if (!sp) return ESPACE;
+
+    const space::snapshot_t& snap = sp->snapshot();
+    const std::size_t m = snap.rows();
+    const double dimensions = space::symbol_t::dimensions;
+    const mms::similarity_join join(m, space::symbol_t::n_elements, mlb);
+
+    const std::size_t nblocks = join.blocks();
+    buffers.assign(nblocks, std::vector<join_entry>());
+
+    auto row = [&snap](const std::size_t i) {
+      return reinterpret_cast<const mms::kernels::word_t*>(snap.row(i));
+    };
+    auto count = [&snap](const std::size_t i) { return snap.count(i); };
+
+    auto pairs = [&](std::size_t b) {
+      std::vector<join_entry>& out = buffers[b];
+      join.join(b, row, count, [&](const std::size_t i, const std::size_t j,
+                                   const double similarity, const std::size_t) {
+          // apply d-filter each way round
+          if (snap.count(j) / dimensions <= dub)
+            out.push_back(join_entry{std::uint32_t(i), std::uint32_t(j), similarity});
+          if (i != j && snap.count(i) / dimensions <= dub)
+            out.push_back(join_entry{std::uint32_t(j), std::uint32_t(i), similarity});
+        });
+    };
+
+    #if HAVE_DISPATCH
+    dispatch_apply(nblocks, DISPATCH_APPLY_AUTO, ^(std::size_t b) {
+        pairs(b);
+      });
+
+    #elif HAVE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    for (std::size_t b=0; b < nblocks; ++b) pairs(b);
+
+    #else
+    for (std::size_t b=0; b < nblocks; ++b) pairs(b);
+    #endif
+
+    return AOK;
+  }
+
+
+  /// nn-descent rounds over the snapshot: rows join their neighbour
+  /// samples in parallel a block at a time and the proposals are then
+  /// taken up in row order so the result is the same on any number of
+  /// threads
+
+  sdm_status_t
+  manifold::knn_graph(const std::string& space_name,
+                      std::vector<std::vector<join_entry>>& graph,
+                      const std::size_t k,
+                      const unsigned rounds,
+                      const std::uint64_t seed,
+                      const double rho,
+                      const double delta) {
+
+    manifold::space* sp = get_space_by_name(space_name);
+    if (!sp) return ESPACE;
+
+    const space::snapshot_t& snap = sp->snapshot();
+    const std::size_t m = snap.rows();
+    const double dimensions = space::symbol_t::dimensions;
+    mms::nn_descent nn(m, space::symbol_t::n_elements, k, seed);
+
+    auto row = [&snap](const std::size_t i) {
+      return reinterpret_cast<const mms::kernels::word_t*>(snap.row(i));
+    };
+
+    const std::size_t block = 4096;
+    std::vector<std::vector<mms::nn_descent::proposal>> proposals(std::min(block, m));
+
+    for (std::size_t a = 0; a < m; a += block) {
+      const std::size_t b = std::min(a + block, m);
+      auto init = [&](std::size_t v) { nn.init(a + v, row); };
+
+      #if HAVE_DISPATCH
+      dispatch_apply(b - a, DISPATCH_APPLY_AUTO, ^(std::size_t v) {
+          init(v);
+        });
+
+      #elif HAVE_OPENMP
+      #pragma omp parallel for schedule(dynamic, 64)
+      for (std::size_t v=0; v < b - a; ++v) init(v);
+
+      #else
+      for (std::size_t v=0; v < b - a; ++v) init(v);
+      #endif
     }
+
+    for (unsigned r = 0; r < rounds; ++r) {
+      nn.sample(rho, r);
+      std::size_t changed = 0;
+
+      for (std::size_t a = 0; a < m; a += block) {
+        const std::size_t b = std::min(a + block, m);
+        auto join = [&](std::size_t v) {
+          proposals[v].clear();
+          nn.join(a + v, row, proposals[v]);
+        };
+
+        #if HAVE_DISPATCH
+        dispatch_apply(b - a, DISPATCH_APPLY_AUTO, ^(std::size_t v) {
+            join(v);
+          });
+
+        #elif HAVE_OPENMP
+        #pragma omp parallel for schedule(dynamic, 64)
+        for (std::size_t v=0; v < b - a; ++v) join(v);
+
+        #else
+        for (std::size_t v=0; v < b - a; ++v) join(v);
+        #endif
+
+        for (std::size_t v = 0; v < b - a; ++v) changed += nn.apply(proposals[v]);
+      }
+
+      if (changed <= delta * m * nn.degree()) break;
+    }
+
+    graph.assign(m, std::vector<join_entry>());
+    for (std::size_t i = 0; i < m; ++i) {
+      const mms::nn_descent::entry* l = nn.neighbours(i);
+      graph[i].reserve(nn.degree());
+      for (std::size_t j = 0; j < nn.degree(); ++j)
+        graph[i].push_back(join_entry{std::uint32_t(i), l[j].id, 1.0 - l[j].distance / dimensions});
+    }
+    return AOK;
+  }
+
+
+  /// approximate topology from the space's graph index, inverted file or
+  /// lsh in that order -- candidates are scored exactly so the answer is
+  /// a subset of the exact topology. When the lsh buckets hold most of
+  /// the space a scan is cheaper and exact
+
+  sdm_status_t
+  manifold::get_topology_approx(const std::string& targetspace,
+                                const sdm_vector_t& vector,
+                                topology& topo,
+                                const double dub,
+                                const double mlb,
+                                const sdm_size_t cub,
+                                const std::size_t effort) {
+
+    manifold::space* sp = get_space_by_name(targetspace);
+    if (!sp) return ESPACE; // space not found
+
+    svector target(vector);
+    std::vector<std::size_t> candidates;
+
+    // ef no smaller than the answer wanted
+    const std::size_t ef = std::max<std::size_t>(effort, std::min<std::size_t>(cub, sp->entries()));
+    if (sp->hnsw_candidates(target, ef, candidates)
+        || sp->ivf_candidates(target, effort, candidates)
+        || sp->lsh_candidates(target, effort, sp->entries() / 2, candidates)) {
+      scan_topology<mms::similarity_metric>(sp, target, topo, 0.0, dub, mlb, unbounded, cub, &candidates);
+
+    } else if (sp->lsh_tables() > 0) {
+      scan_topology<mms::similarity_metric>(sp, target, topo, 0.0, dub, mlb, unbounded, cub);
+
+    } else return EINDEX;
+
+    return AOK;
+  }
+
+
+  /// two stage topology: chunks of the sketch matrix keep heaps of the
+  /// shortlist nearest sketches (skipping rows the density or popcount
+  /// bounds rule out) and the best shortlist of them all are ranked
+  /// exactly -- a subset of the exact topology that streams a sixteenth
+  /// of the space
+
+  sdm_status_t
+  manifold::get_topology_sketched(const std::string& targetspace,
+                                  const sdm_vector_t& vector,
+                                  topology& topo,
+                                  const double dub,
+                                  const double mlb,
+                                  const sdm_size_t cub,
+                                  const std::size_t shortlist) {
+
+    manifold::space* sp = get_space_by_name(targetspace);
+    if (!sp) return ESPACE;
+
+    svector target(vector);
+    const space::snapshot_t& snap = sp->snapshot();
+    const std::size_t m = snap.rows();
+    const std::size_t l = std::min<std::size_t>(shortlist ? shortlist : 16 * std::min<std::size_t>(cub, m), m);
+    if (l == 0) return AOK;
+
+    const double dimensions = space::symbol_t::dimensions;
+    const mms::kernels::popcount_kernels& kernel = mms::kernels::dispatch();
+    const std::size_t tc = kernel.count(target.words(), space::symbol_t::n_elements);
+    const std::size_t radius = reach(mlb);
+
+    space::symbol_t::element_t ts[space::snapshot_t::sketch_words];
+    space::snapshot_t::sketch_of(reinterpret_cast<const space::symbol_t::element_t*>(target.words()), ts);
+    const mms::kernels::word_t* tw = reinterpret_cast<const mms::kernels::word_t*>(ts);
+
+    // (sketch distance, row) heaps with the farthest on top
+    typedef std::pair<std::size_t, std::size_t> scored_t;
+    const std::size_t chunk = 16384;
+    const std::size_t nchunks = (m + chunk - 1) / chunk;
+    std::vector<std::vector<scored_t>> heaps(nchunks);
+
+    auto scan = [&](std::size_t c) {
+      std::vector<scored_t>& heap = heaps[c];
+      const std::size_t b = std::min(c * chunk + chunk, m);
+      for (std::size_t i = c * chunk; i < b; ++i) {
+        const std::size_t vc = snap.count(i);
+        if (vc / dimensions > dub || (vc > tc ? vc - tc : tc - vc) > radius) continue;
+        const scored_t s(kernel.distance(tw, reinterpret_cast<const mms::kernels::word_t*>(snap.sketch(i)),
+                                         space::snapshot_t::sketch_words), i);
+        if (heap.size() < l) {
+          heap.push_back(s);
+          std::push_heap(heap.begin(), heap.end());
+        } else if (s < heap.front()) {
+          std::pop_heap(heap.begin(), heap.end());
+          heap.back() = s;
+          std::push_heap(heap.begin(), heap.end());
+        }
+      }
+    };
+
+    #if HAVE_DISPATCH
+    dispatch_apply(nchunks, DISPATCH_APPLY_AUTO, ^(std::size_t c) {
+        scan(c);
+      });
+
+    #elif HAVE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    for (std::size_t c=0; c < nchunks; ++c) scan(c);
+
+    #else
+    for (std::size_t c=0; c < nchunks; ++c) scan(c);
     #endif
 
-        
-    // filter work array on density and similarity bounds
-    for (std::size_t i=0; i < m; ++i) {
-      double r = work[i*3];
-      double s = work[i*3+1];
-      double o = work[i*3+2];
-      // apply p-d-filter
-      if (r <= dub && s >= mlb) {
-        neighbour n(sp->symbol_at(i).name(), r, s, o);
-        topo.push_back(n);
+    std::vector<scored_t> nearest;
+    for (auto& h: heaps) nearest.insert(nearest.end(), h.begin(), h.end());
+    if (nearest.size() > l) {
+      std::nth_element(nearest.begin(), nearest.begin() + l, nearest.end());
+      nearest.resize(l);
+    }
+
+    std::vector<std::size_t> candidates;
+    candidates.reserve(nearest.size());
+    for (auto& s: nearest) candidates.push_back(s.second);
+    std::sort(candidates.begin(), candidates.end());
+
+    if (!candidates.empty())
+      scan_topology<mms::similarity_metric>(sp, target, topo, 0.0, dub, mlb, unbounded, cub, &candidates);
+    return AOK;
+  }
+
+
+  /// symbols holding the bits of an elemental basis -- similarity is
+  /// the fraction of basis bits held and overlap their share of the
+  /// dimensions
+
+  sdm_status_t
+  manifold::get_basis_overlap(const std::string& targetspace,
+                              const std::string& sourcespace,
+                              const std::string& name,
+                              topology& topo,
+                              const double mlb,
+                              const sdm_size_t cub,
+                              const int shift) {
+
+    manifold::space* tsp = get_space_by_name(targetspace);
+    if (!tsp) return ESPACE;
+
+    manifold::space* ssp = get_space_by_name(sourcespace);
+    if (!ssp) return ESPACE;
+
+    auto sym = ssp->get_symbol_by_name(name);
+    if (!sym) return ESYMBOL;
+
+    const space::basis_view_t basis = sym->basis();
+    const std::size_t bits = basis.size();
+    if (bits == 0) return AOK;
+    const std::size_t least = std::max<std::size_t>(1, std::ceil(mlb * bits));
+    const double dimensions = space::symbol_t::dimensions;
+
+    // (position, bits held) from the postings or else a scan testing
+    // just the basis bits of every row
+    std::vector<std::pair<std::size_t, std::size_t>> hits;
+    if (!tsp->basis_overlap(basis, shift, least, hits)) {
+      const space::snapshot_t& snap = tsp->snapshot();
+      for (std::size_t i = 0; i < snap.rows(); ++i) {
+        const auto* row = snap.row(i);
+        std::size_t held = 0;
+        for (auto b: basis) {
+          const unsigned r = (b + shift) % space::symbol_t::dimensions;
+          held += (row[r / 64] >> (r % 64)) & 1;
+        }
+        if (held >= least) hits.push_back(std::make_pair(i, held));
       }
     }
 
-    delete[] work;
-    
-    // sort the scores in similarity order
-    sort(topo.begin(), topo.end());
-    const std::size_t ns = topo.size();
+    std::vector<ranked> ranking;
+    ranking.reserve(hits.size());
+    for (auto& h: hits)
+      ranking.push_back(ranked{h.first, tsp->symbol_at(h.first).count() / dimensions,
+                               double(h.second) / bits, h.second / dimensions,
+                               double(h.second) / bits, double(h.second) / bits});
 
-    // chop off uneeded tail
-    topo.erase(topo.begin() + ((cub < ns) ? cub : ns), topo.end());
+    const std::size_t k = std::min<std::size_t>(cub, ranking.size());
+    std::partial_sort(ranking.begin(), ranking.begin() + k, ranking.end());
+    topo.reserve(topo.size() + k);
+    for (std::size_t i = 0; i < k; ++i)
+      topo.push_back(neighbour(tsp->symbol_at(ranking[i].index).name(),
+                               ranking[i].density, ranking[i].similarity, ranking[i].overlap));
+    return AOK;
+  }
+
+
+  /// density order for range limited scans
+
+  sdm_status_t
+  manifold::order_by_density(const std::string& sn, const bool on) noexcept {
+    auto sp = get_space_by_name(sn);
+    if (!sp) return ESPACE;
+    sp->order_by_density(on);
     return AOK;
-    
   }
-  
   
 
   /*
@@ -325,6 +1425,33 @@ namespace sdm {
   */
 
   
+  /// resolve names once to ids for the handle taking operations
+
+  std::pair<sdm_status_t, sdm_handle_t>
+  manifold::resolve(const std::string& sn,
+                    const std::string& vn) noexcept {
+    sdm_handle_t h = {0, 0};
+    auto sid = resolve_space(sn);
+    if (sdm_error(sid.first)) return std::make_pair(sid.first, h);
+
+    space* sp = space_ids[sid.second];
+    auto sym = sp->get_symbol_by_name(vn);
+    if (!sym) return std::make_pair(ESYMBOL, h);
+
+    h.space = sid.second;
+    h.symbol = sp->position(*sym);
+    return std::make_pair(AOK, h);
+  }
+
+
+  std::pair<sdm_status_t, unsigned>
+  manifold::resolve_space(const std::string& sn) noexcept {
+    space* sp = get_space_by_name(sn);
+    if (!sp) return std::make_pair(ESPACE, 0u);
+    return std::make_pair(AOK, unsigned(std::find(space_ids.begin(), space_ids.end(), sp) - space_ids.begin()));
+  }
+
+  
   /// return cardinality of a space
     
   std::pair<sdm_status_t, std::size_t>
@@ -377,6 +1504,7 @@ namespace sdm {
       try {
         space* sp = new space(name, heap);
         spaces[name] = sp;
+        space_ids.push_back(sp);
         return std::make_pair(ANEW, sp);
         
       } catch (boost::interprocess::bad_alloc& e) {
@@ -49,10 +49,18 @@ namespace sdm {
     /// space implementation determines the type and number of elements and sparsity
     /// of vectors
     
+    #if SDM_FLAT_SYMBOLS
+    typedef mms::symbol_space<SDM_VECTOR_ELEMENT_TYPE,
+                              SDM_VECTOR_ELEMS,
+                              SDM_VECTOR_BASIS_SIZE,
+                              segment_t,
+                              mms::flat_symbol> space;
+    #else
     typedef mms::symbol_space<SDM_VECTOR_ELEMENT_TYPE,
                               SDM_VECTOR_ELEMS,
                               SDM_VECTOR_BASIS_SIZE,
                               segment_t> space;
+    #endif
 
 
     
@@ -83,20 +91,32 @@ namespace sdm {
       
       double similarity;
       double overlap;
+      double metric;          // value of the metric ranked by
+      sdm_metric_t ranked_by;
       
       explicit
       neighbour(const std::string& v,
                 const double d,
                 const double s,
-                const double o) : point(v, d), similarity(s), overlap(o) {}
+                const double o) : point(v, d), similarity(s), overlap(o),
+                                  metric(s), ranked_by(::similarity) {}
+
+      explicit
+      neighbour(const std::string& v,
+                const double d,
+                const double s,
+                const double o,
+                const double m,
+                const sdm_metric_t by) : point(v, d), similarity(s), overlap(o),
+                                         metric(m), ranked_by(by) {}
       
       
       /// comparison operators for sorting w.r.t metric
       // in order to compute topology of nearest neighbours
-      // to a given vector
+      // to a given vector -- hamming distance is nearest first
       
       bool operator< (const neighbour& s) const {
-        return similarity > s.similarity;
+        return (ranked_by == ::hamming) ? metric < s.metric : metric > s.metric;
       }
       
       bool operator==(const neighbour& s) const {
@@ -118,9 +138,9 @@ namespace sdm {
     typedef std::vector<point> geometry;
     typedef std::vector<neighbour> topology;
     
-    // xx plannning to use this for all semantic vector data in space for search etc.
-    // might need a few types -- some will need to be gpu compatible.
-    //typedef Eigen::Matrix<SDM_VECTOR_ELEMENT_TYPE, SDM_VECTOR_ELEMS, Eigen::Dynamic> matrix_t;
+    // all semantic vector data in a space for search is held in the
+    // space::snapshot_t matrix -- might need a few types, some will need
+    // to be gpu compatible.
 
 
     sdm_status_t
@@ -133,26 +153,132 @@ namespace sdm {
                    const std::string& name,
                    sdm_sparse_t bits);
 
+    sdm_status_t
+    load_vector(const sdm_handle_t& symbol,
+                sdm_vector_t vector) noexcept;
+
+
+    ///////////////////////////////////////
+    /// resolve once handles on symbols ///
+    ///////////////////////////////////////
+
+    /// ids of a space and a symbol in it for the handle taking
+    /// operations -- positions in the space are never reused so a
+    /// handle stays good while the database is open whatever else is
+    /// inserted, but not across opens
+    std::pair<sdm_status_t, sdm_handle_t>
+    resolve(const std::string& space_name,
+            const std::string& symbol_name) noexcept;
+
+    /// id of a space as in handles
+    std::pair<sdm_status_t, unsigned>
+    resolve_space(const std::string& space_name) noexcept;
+
 
 
     // XXX attempting c and c++ versions here
     // XXX could inline all the c++ implementations and only build a C library
 
     // apply a metric to get a subset of the space
-    /*
-    // ? move to sdmlib for c-api
+
+    /// the best cub symbols by metric of those with density in [dlb,
+    /// dub] and metric in [mlb, mub]: similarity, overlap and jaccard
+    /// rank largest first and hamming (in bits) nearest first
     sdm_status_t
     get_topology(const std::string& targetspace,
                  const sdm_vector_t& vector,
                  const sdm_size_t cub,
-                 //const sdm_metric_t metric,
+                 const sdm_metric_t metric,
                  const double dlb,
                  const double dub,
                  const double mlb,
                  const double mub,
-                 sdm_topology_t& top);
+                 topology& top);
+
+    sdm_status_t
+    get_topology(const std::string& targetspace,
+                 const std::string& sourcespace,
+                 const std::string& vectorname,
+                 const sdm_size_t cub,
+                 const sdm_metric_t metric,
+                 const double dlb,
+                 const double dub,
+                 const double mlb,
+                 const double mub,
+                 topology& top);
+
+    /// as above into cub entries of a c topology named by the mapped
+    /// symbol names -- a null name ends a short topology
+    sdm_status_t
+    get_topology(const std::string& targetspace,
+                 const sdm_vector_t& vector,
+                 const sdm_size_t cub,
+                 const sdm_metric_t metric,
+                 const double dlb,
+                 const double dub,
+                 const double mlb,
+                 const double mub,
+                 sdm_topology_t top);
+
+    /// by handle on the source symbol and id of the target space
+    sdm_status_t
+    get_topology(const unsigned targetspace,
+                 const sdm_handle_t& source,
+                 const sdm_size_t cub,
+                 const sdm_metric_t metric,
+                 const double dlb,
+                 const double dub,
+                 const double mlb,
+                 const double mub,
+                 topology& top);
+
+    sdm_status_t
+    get_topology(const unsigned targetspace,
+                 const sdm_handle_t& source,
+                 const sdm_size_t cub,
+                 const sdm_metric_t metric,
+                 const double dlb,
+                 const double dub,
+                 const double mlb,
+                 const double mub,
+                 sdm_topology_t top);
+
+    sdm_status_t
+    get_topology(const unsigned targetspace,
+                 const sdm_handle_t& source,
+                 topology& topo,
+                 const double dub = 0.5,
+                 const double mlb = 0.5,
+                 const sdm_size_t cub = -1);
+
+    /// level set cardinality: the number of symbols with density in
+    /// [dlb, dub] and metric in [mlb, mub] and, if histogram is not
+    /// empty, how many of them fall in each of histogram.size() equal
+    /// buckets of [mlb, mub] (clipped to the metric's range) -- nothing
+    /// is named or ranked
+    sdm_status_t
+    count_topology(const std::string& targetspace,
+                   const sdm_vector_t& vector,
+                   const sdm_metric_t metric,
+                   const double dlb,
+                   const double dub,
+                   const double mlb,
+                   const double mub,
+                   std::size_t& count,
+                   std::vector<std::size_t>& histogram);
+
+    sdm_status_t
+    count_topology(const std::string& targetspace,
+                   const std::string& sourcespace,
+                   const std::string& vectorname,
+                   const sdm_metric_t metric,
+                   const double dlb,
+                   const double dub,
+                   const double mlb,
+                   const double mub,
+                   std::size_t& count,
+                   std::vector<std::size_t>& histogram);
 
-    */
     sdm_status_t
     get_topology(const std::string& targetspace,
                  const std::string& sourcespace,
@@ -166,7 +292,7 @@ namespace sdm {
     // wrapper type for non-heap allocated vectors  
     typedef mms::ephemeral_vector<SDM_VECTOR_ELEMENT_TYPE,
                                   SDM_VECTOR_ELEMS,
-                                  space::vector_t> svector;
+                                  space::vector_view_t> svector;
     //
     sdm_status_t
     get_topology(const std::string& targetspace,
@@ -176,6 +302,121 @@ namespace sdm {
                  const double mlb = 0.5,
                  const sdm_size_t cub = -1);
 
+    /// topology among the symbols of targetspace whose names start
+    /// with prefix: only that range of the name index is scored
+    sdm_status_t
+    get_topology(const std::string& targetspace,
+                 const std::string& sourcespace,
+                 const std::string& vectorname,
+                 const std::string& prefix,
+                 topology& topo,
+                 const double dub = 0.5,
+                 const double mlb = 0.5,
+                 const sdm_size_t cub = -1);
+
+    sdm_status_t
+    get_topology(const std::string& targetspace,
+                 const sdm_vector_t& vector,
+                 const std::string& prefix,
+                 topology& top,
+                 const double dub = 0.5,
+                 const double mlb = 0.5,
+                 const sdm_size_t cub = -1);
+
+    /// topology of each of n vectors from one pass over the space:
+    /// blocks of the space are scored against every query while cached
+    sdm_status_t
+    get_topology_batch(const std::string& targetspace,
+                       const sdm_vector_t* vectors,
+                       const std::size_t n,
+                       std::vector<topology>& topos,
+                       const double dub = 0.5,
+                       const double mlb = 0.5,
+                       const sdm_size_t cub = -1);
+
+    /// topology of each of the named vectors of sourcespace: ESYMBOL if
+    /// any is missing
+    sdm_status_t
+    get_topology_batch(const std::string& targetspace,
+                       const std::string& sourcespace,
+                       const std::vector<std::string>& names,
+                       std::vector<topology>& topos,
+                       const double dub = 0.5,
+                       const double mlb = 0.5,
+                       const sdm_size_t cub = -1);
+
+    /// a pair of symbols of a space by position (as in get_geometry)
+    struct join_entry {
+      std::uint32_t i;
+      std::uint32_t j;
+      double similarity;
+    };
+
+    /// every ordered pair (i, j) of symbols of a space with similarity
+    /// of at least mlb and j no denser than dub, each pair scored once:
+    /// pairs land in one buffer per parallel task, in no particular order
+    sdm_status_t
+    similarity_join(const std::string& space,
+                    std::vector<std::vector<join_entry>>& buffers,
+                    const double dub = 1.0,
+                    const double mlb = 0.5);
+
+    /// approximate graph of the k nearest symbols of each symbol of a
+    /// space by nn-descent: graph[i] lists those of symbol i nearest
+    /// first. Rounds sample rho k neighbours and stop early once fewer
+    /// than delta of the neighbours change; the graph depends only on
+    /// seed and not on the number of threads
+    sdm_status_t
+    knn_graph(const std::string& space,
+              std::vector<std::vector<join_entry>>& graph,
+              const std::size_t k = 20,
+              const unsigned rounds = 12,
+              const std::uint64_t seed = 0,
+              const double rho = 0.5,
+              const double delta = 0.001);
+
+    /// approximate topology from the space's search graph with effort
+    /// (hnsw ef) per query, its inverted file probing effort partitions
+    /// or its lsh with effort probes per table: EINDEX if it has none
+    sdm_status_t
+    get_topology_approx(const std::string& targetspace,
+                        const sdm_vector_t& vector,
+                        topology& top,
+                        const double dub = 0.5,
+                        const double mlb = 0.5,
+                        const sdm_size_t cub = 20,
+                        const std::size_t effort = 64);
+
+    /// topology in two stages: the snapshot sketches of the space are
+    /// scanned for the shortlist nearest (0 for 16 cub) and only those
+    /// are ranked exactly -- needs no index
+    sdm_status_t
+    get_topology_sketched(const std::string& targetspace,
+                          const sdm_vector_t& vector,
+                          topology& top,
+                          const double dub = 0.5,
+                          const double mlb = 0.5,
+                          const sdm_size_t cub = 20,
+                          const std::size_t shortlist = 0);
+
+    /// symbols of targetspace that have absorbed the elemental basis of
+    /// a symbol of sourcespace (shifted as by superpose) ranked by the
+    /// fraction of its bits they hold, at least mlb: answered from the
+    /// space's bit postings when it has them or else by a scan
+    sdm_status_t
+    get_basis_overlap(const std::string& targetspace,
+                      const std::string& sourcespace,
+                      const std::string& name,
+                      topology& topo,
+                      const double mlb = 0.5,
+                      const sdm_size_t cub = 20,
+                      const int shift = 0);
+
+    /// keep a space in density order so topology queries only scan
+    /// the popcount range that can meet their bounds
+    sdm_status_t
+    order_by_density(const std::string& space_name, const bool on = true) noexcept;
+    
     /* move to sdmlib c api 
     sdm_status_t
     get_geometry(const std::string&,
@@ -195,6 +436,28 @@ namespace sdm {
     std::pair<sdm_status_t, symbol_list>
     prefix_search(const std::string& space_name,
                   const std::string& symbol_prefix) noexcept;
+
+    /// number of symbols starting with prefix without walking them
+    std::pair<sdm_status_t, std::size_t>
+    prefix_count(const std::string& space_name,
+                 const std::string& symbol_prefix) noexcept;
+
+    /// a page of at most n symbols starting with prefix from cursor on
+    /// -- start with cursor 0 and it is advanced past each page, an
+    /// empty page ends the range. Each page costs O(log n + page)
+    std::pair<sdm_status_t, symbol_list>
+    prefix_page(const std::string& space_name,
+                const std::string& symbol_prefix,
+                std::size_t& cursor,
+                const std::size_t n) noexcept;
+
+    /// as above into sdm points -- a null name ends a short page
+    sdm_status_t
+    prefix_page(const std::string& space_name,
+                const std::string& symbol_prefix,
+                std::size_t& cursor,
+                const std::size_t n,
+                sdm_geometry_t page) noexcept;
     
     
     /////////////////////////
@@ -206,6 +469,9 @@ namespace sdm {
     density(const std::string& space_name,
             const std::string& vector_name) noexcept;
 
+    std::pair<const sdm_status_t, const double>
+    density(const sdm_handle_t&) noexcept;
+
 
     /////////////////////////
     /// vector measurement //
@@ -217,12 +483,18 @@ namespace sdm {
     similarity(const std::string&, const std::string&,
                const std::string&, const std::string&) noexcept;
 
+    const std::pair<const sdm_status_t, const double>
+    similarity(const sdm_handle_t&, const sdm_handle_t&) noexcept;
+
     /// inner product (overlap)
     
     const std::pair<const sdm_status_t, const double>
     overlap(const std::string&, const std::string&,
             const std::string&, const std::string&) noexcept;
 
+    const std::pair<const sdm_status_t, const double>
+    overlap(const sdm_handle_t&, const sdm_handle_t&) noexcept;
+
     /// get spaces in manifold
 
     std::vector<std::string>
@@ -240,6 +512,105 @@ namespace sdm {
       auto it = spaces.find(name);
       return (it == spaces.end()) ? nullptr : it->second;
     }
+
+    inline space*
+    get_space_by_id(const unsigned id) noexcept {
+      return (id < space_ids.size()) ? space_ids[id] : nullptr;
+    }
+
+    /// space and symbol of a handle -- null where they are not found
+    inline std::pair<space*, space::symbol_t*>
+    get_by_handle(const sdm_handle_t& h) noexcept {
+      space* sp = get_space_by_id(h.space);
+      if (!sp || h.symbol >= sp->entries()) return std::make_pair(sp, nullptr);
+      return std::make_pair(sp, &sp->symbol_at(h.symbol));
+    }
+
+
+    /// scored candidate kept by index so names are only copied for winners
+
+    struct ranked {
+      std::size_t index;
+      double density;
+      double similarity;
+      double overlap;
+      double metric;
+      double score;    // metric oriented so larger is better
+
+      /// better score first and ties broken by position in the space
+      bool operator< (const ranked& r) const {
+        return score > r.score || (score == r.score && index < r.index);
+      }
+    };
+
+    /// top-k scan of space for target vector by metric M shared by the
+    /// get_topology variants
+    template <typename M, typename V>
+    void scan_topology(space* sp,
+                       const V& target,
+                       topology& topo,
+                       const double dlb,
+                       const double dub,
+                       const double mlb,
+                       const double mub,
+                       const sdm_size_t cub,
+                       const std::vector<std::size_t>* only = nullptr);
+
+    /// scan_topology by a metric chosen at runtime
+    template <typename V>
+    void scan_topology(space* sp,
+                       const V& target,
+                       topology& topo,
+                       const sdm_metric_t metric,
+                       const double dlb,
+                       const double dub,
+                       const double mlb,
+                       const double mub,
+                       const sdm_size_t cub);
+
+    /// counting scan of space for target vector by metric M
+    template <typename M, typename V>
+    void count_scan(space* sp,
+                    const V& target,
+                    const double dlb,
+                    const double dub,
+                    const double mlb,
+                    const double mub,
+                    std::size_t& count,
+                    std::vector<std::size_t>& histogram);
+
+    /// count_scan by a metric chosen at runtime
+    template <typename V>
+    void count_scan(space* sp,
+                    const V& target,
+                    const sdm_metric_t metric,
+                    const double dlb,
+                    const double dub,
+                    const double mlb,
+                    const double mub,
+                    std::size_t& count,
+                    std::vector<std::size_t>& histogram);
+
+    /// top-k scans for many targets sharing one pass over the space
+    void scan_topology_batch(space* sp,
+                             const std::vector<const mms::kernels::word_t*>& targets,
+                             std::vector<topology>& topos,
+                             const double dub,
+                             const double mlb,
+                             const sdm_size_t cub);
+
+    /// hamming distance bound of similarity s
+    static std::size_t reach(const double s);
+
+    /// offer r to a bounded heap of the k best
+    static void admit(std::vector<ranked>& heap, const ranked& r, const std::size_t k);
+
+    /// name the best k of sorted per chunk winners ranked by metric
+    static void merge_topology(space* sp,
+                               const std::vector<std::vector<ranked>>& heaps,
+                               const std::size_t k,
+                               topology& topo,
+                               const sdm_metric_t metric = ::similarity);
    
 
     /// access cache of pointers to named spaces to optimize symbol lookup
@@ -254,6 +625,7 @@ namespace sdm {
 
     // read through space cache
     std::map<const std::string, space*> spaces; // run time space index
+    std::vector<space*> space_ids;              // and by id for handles
     // todo read through toppology cache
 
   };
@@ -39,6 +39,40 @@ sdm_database_close(const database_t db) {
 
 
 
+const sdm_status_t
+sdm_superpose(const database_t db,
+              const sdm_name_t target_space_name,
+              const sdm_name_t target_symbol_name,
+              const sdm_name_t source_space_name,
+              const sdm_name_t source_symbol_name,
+              const int shift) {
+
+  return static_cast<database*>(db)->superpose(std::string(target_space_name),
+                                               std::string(target_symbol_name),
+                                               std::string(source_space_name),
+                                               std::string(source_symbol_name),
+                                               shift);
+}
+
+
+const sdm_status_t
+sdm_superpose_batch(const database_t db,
+                    const sdm_name_t target_space_name,
+                    const sdm_name_t target_symbol_name,
+                    const sdm_name_t source_space_name,
+                    const sdm_name_t* source_symbol_names,
+                    const sdm_size_t n,
+                    const int* shifts) {
+
+  std::vector<std::string> sources(source_symbol_names, source_symbol_names + n);
+  return static_cast<database*>(db)->superpose(std::string(target_space_name),
+                                               std::string(target_symbol_name),
+                                               std::string(source_space_name),
+                                               sources,
+                                               shifts ? std::vector<int>(shifts, shifts + n) : std::vector<int>());
+}
+
+
 const sdm_status_t
 sdm_load_vector(const database_t db,
                 const sdm_name_t space_name,
@@ -50,6 +84,144 @@ sdm_load_vector(const database_t db,
                                                  vector);
 }
 
+
+const sdm_status_t
+sdm_get_topology(const database_t db,
+                 const sdm_name_t target_space,
+                 const sdm_vector_t vector,
+                 const sdm_size_t cub,
+                 const sdm_metric_t metric,
+                 const double dlb,
+                 const double dub,
+                 const double mlb,
+                 const double mub,
+                 sdm_topology_t top) {
+  try {
+    return static_cast<database*>(db)->get_topology(std::string(target_space),
+                                                    *reinterpret_cast<const sdm_vector_t*>(vector),
+                                                    cub, metric, dlb, dub, mlb, mub, top);
+  } catch (const std::bad_alloc& e) {
+    return EMEMORY;
+  }
+}
+
+
+const sdm_status_t
+sdm_resolve(const database_t db,
+            const sdm_name_t space_name,
+            const sdm_name_t symbol_name,
+            sdm_handle_t* handle) {
+  auto r = static_cast<database*>(db)->resolve(std::string(space_name), std::string(symbol_name));
+  *handle = r.second;
+  return r.first;
+}
+
+const sdm_status_t
+sdm_resolve_space(const database_t db,
+                  const sdm_name_t space_name,
+                  unsigned* space) {
+  auto r = static_cast<database*>(db)->resolve_space(std::string(space_name));
+  *space = r.second;
+  return r.first;
+}
+
+const sdm_status_t
+sdm_ensure_handle(const database_t db,
+                  const sdm_name_t space_name,
+                  const sdm_name_t symbol_name,
+                  const sdm_prob_t p,
+                  sdm_handle_t* handle) {
+  auto r = static_cast<database*>(db)->ensure_handle(std::string(space_name), std::string(symbol_name), p);
+  *handle = r.second;
+  return r.first;
+}
+
+const sdm_status_t
+sdm_superpose_handle(const database_t db,
+                     const sdm_handle_t target,
+                     const sdm_handle_t source,
+                     const int shift) {
+  return static_cast<database*>(db)->superpose(target, source, shift);
+}
+
+const sdm_status_t
+sdm_bundle_handles(const database_t db,
+                   const sdm_handle_t* terms,
+                   const sdm_size_t n) {
+  return static_cast<database*>(db)->bundle(std::vector<sdm_handle_t>(terms, terms + n));
+}
+
+const sdm_status_t
+sdm_similarity_handle(const database_t db,
+                      const sdm_handle_t a,
+                      const sdm_handle_t b,
+                      double* similarity) {
+  auto r = static_cast<database*>(db)->similarity(a, b);
+  *similarity = r.second;
+  return r.first;
+}
+
+const sdm_status_t
+sdm_overlap_handle(const database_t db,
+                   const sdm_handle_t a,
+                   const sdm_handle_t b,
+                   double* overlap) {
+  auto r = static_cast<database*>(db)->overlap(a, b);
+  *overlap = r.second;
+  return r.first;
+}
+
+const sdm_status_t
+sdm_density_handle(const database_t db,
+                   const sdm_handle_t h,
+                   double* density) {
+  auto r = static_cast<database*>(db)->density(h);
+  *density = r.second;
+  return r.first;
+}
+
+const sdm_status_t
+sdm_load_vector_handle(const database_t db,
+                       const sdm_handle_t h,
+                       sdm_vector_t vector) {
+  return static_cast<database*>(db)->load_vector(h, vector);
+}
+
+const sdm_status_t
+sdm_get_topology_handle(const database_t db,
+                        const unsigned target_space,
+                        const sdm_handle_t source,
+                        const sdm_size_t cub,
+                        const sdm_metric_t metric,
+                        const double dlb,
+                        const double dub,
+                        const double mlb,
+                        const double mub,
+                        sdm_topology_t top) {
+  try {
+    return static_cast<database*>(db)->get_topology(target_space, source, cub, metric, dlb, dub, mlb, mub, top);
+  } catch (const std::bad_alloc& e) {
+    return EMEMORY;
+  }
+}
+
+const sdm_status_t
+sdm_prefix_search(const database_t db,
+                  const sdm_name_t space_name,
+                  const sdm_name_t prefix,
+                  const sdm_size_t card,
+                  sdm_size_t* cursor,
+                  sdm_size_t* matches,
+                  sdm_geometry_t page) {
+  auto rts = static_cast<database*>(db);
+  if (matches) {
+    auto r = rts->prefix_count(std::string(space_name), std::string(prefix));
+    if (sdm_error(r.first)) return r.first;
+    *matches = r.second;
+  }
+  return rts->prefix_page(std::string(space_name), std::string(prefix), *cursor, card, page);
+}
+
 #ifdef NOTDEF
 
 const status_t sdm_database(const char* filename,
@@ -40,6 +40,19 @@ extern "C" {
                 const sdm_name_t source_symbol_name,
                 const int shift);
 
+  /* superpose n symbols of source_space onto the target in one pass,
+     asserting any that are missing -- shifts (if not null) rotate each
+     source basis in turn */
+
+  const sdm_status_t
+  sdm_superpose_batch(const database_t,
+                      const sdm_name_t target_space_name,
+                      const sdm_name_t target_symbol_name,
+                      const sdm_name_t source_space_name,
+                      const sdm_name_t* source_symbol_names,
+                      const sdm_size_t n,
+                      const int* shifts);
+
   const sdm_status_t
   sdm_subtract(const database_t,
                const sdm_name_t target_space_name,
@@ -62,6 +75,12 @@ extern "C" {
                      sdm_sparse_t bits);
 
 
+  /* the best cub symbols of target_space by metric with density in
+     [dlb, dub] and metric in [mlb, mub] -- hamming is a distance in
+     bits and ranks nearest first. top must hold cub entries and a null
+     name ends a shorter topology; names stay good while the database
+     is open */
+
   const sdm_status_t
   sdm_get_topology(const database_t,
                    const sdm_name_t target_space,
@@ -80,18 +99,94 @@ extern "C" {
                    const sdm_size_t card,
                    sdm_geometry_t g);
 
-  /* 
-
-  TODO: term_t or sdm_term_list_t 
+  /* names of space_name starting with prefix a page of at most card
+     at a time: start with *cursor 0 and it is advanced past each page,
+     a null name ends a short page and an empty page the range. matches
+     (if not null) is set to the number in the whole range. Names stay
+     good while the database is open */
 
   const sdm_status_t
   sdm_prefix_search(const database_t,
                     const sdm_name_t space_name,
                     const sdm_name_t prefix,
-                    const sdm_size_t card_ub,
-                    term_t* terms);
-  */
+                    const sdm_size_t card,
+                    sdm_size_t* cursor,
+                    sdm_size_t* matches,
+                    sdm_geometry_t page);
   
+  /* resolve once handles: operations by handle skip the name lookups
+     and stay good while the database is open -- sdm_ensure_handle
+     asserts the symbol (and space) as sdm_namedvector does */
+
+  const sdm_status_t
+  sdm_resolve(const database_t,
+              const sdm_name_t space_name,
+              const sdm_name_t symbol_name,
+              sdm_handle_t* handle);
+
+  const sdm_status_t
+  sdm_resolve_space(const database_t,
+                    const sdm_name_t space_name,
+                    unsigned* space);
+
+  const sdm_status_t
+  sdm_ensure_handle(const database_t,
+                    const sdm_name_t space_name,
+                    const sdm_name_t symbol_name,
+                    const sdm_prob_t,
+                    sdm_handle_t* handle);
+
+  const sdm_status_t
+  sdm_superpose_handle(const database_t,
+                       const sdm_handle_t target,
+                       const sdm_handle_t source,
+                       const int shift);
+
+  /* superpose each of n symbols of one space with all the others as
+     symmetric pairwise sdm_superpose_handle calls would */
+
+  const sdm_status_t
+  sdm_bundle_handles(const database_t,
+                     const sdm_handle_t* terms,
+                     const sdm_size_t n);
+
+  const sdm_status_t
+  sdm_similarity_handle(const database_t,
+                        const sdm_handle_t a,
+                        const sdm_handle_t b,
+                        double* similarity);
+
+  const sdm_status_t
+  sdm_overlap_handle(const database_t,
+                     const sdm_handle_t a,
+                     const sdm_handle_t b,
+                     double* overlap);
+
+  const sdm_status_t
+  sdm_density_handle(const database_t,
+                     const sdm_handle_t,
+                     double* density);
+
+  const sdm_status_t
+  sdm_load_vector_handle(const database_t,
+                         const sdm_handle_t,
+                         sdm_vector_t vector);
+
+  /* as sdm_get_topology of target_space (from sdm_resolve_space) for
+     the vector of source */
+
+  const sdm_status_t
+  sdm_get_topology_handle(const database_t,
+                          const unsigned target_space,
+                          const sdm_handle_t source,
+                          const sdm_size_t cub,
+                          const sdm_metric_t metric,
+                          const double dlb,
+                          const double dub,
+                          const double mlb,
+                          const double mub,
+                          sdm_topology_t top);
+
   const sdm_status_t
   sdm_get_cardinality(const database_t,
                       const sdm_name_t space_name,
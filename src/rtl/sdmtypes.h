@@ -50,9 +50,14 @@ typedef float sdm_prob_t; /* [0,1] */
 
 typedef struct sdm_neighbour {sdm_point_t p; double metric; } sdm_neighbour_t;
 
+/* a symbol resolved once: ids of its space and of it in the space that
+   stay good while the database is open */
+
+typedef struct sdm_handle { unsigned space; unsigned symbol; } sdm_handle_t;
+
 typedef sdm_neighbour_t sdm_topology_t[];
 
-enum sdm_metric {similarity, overlap};
+enum sdm_metric {similarity, overlap, jaccard, hamming};
 
 typedef enum sdm_metric sdm_metric_t;
 
@@ -125,29 +125,31 @@ int main(const int argc, const char** argv) {
       index_bimap<std::string> feature_map;
       triplet_vec triplets; // i,j,v triplets for sparse matrix
 
-      // for all points in space
-      for (database::point p : g) {
-        
-        std::cout << "." << std::flush;
-        // get index for name
-        std::size_t i = feature_map.ensure(p.name);
-        // get the topology/level set for this point/vector
-        manifold::topology level_set;
-        level_set.reserve(r.second);
-        // carefully provide all parameters
-        sts = rts.get_topology(space_name, space_name, p.name, level_set,
-                               density_ub, metric_lb, r.second);
-        if (!sdm_error(sts)) {
-          for (database::neighbour n : level_set) {
-            std::size_t j = feature_map.ensure(n.name);
-            triplets.push_back(triplet(i, j, n.similarity)); // XXX could try overlap metric
-          }
-        } else {
-          std::cerr << "failed to get topology: " << sts << " for point: " << p.name << std::endl;
-          return 9;
-        }
+      // features are numbered in geometry order so join positions are
+      // matrix indices
+      for (auto& p: g) feature_map.ensure(p.name);
+
+      // every pair above metric_min from one pass over the upper
+      // triangle of the space
+      std::vector<std::vector<database::join_entry>> buffers;
+      // carefully provide all parameters
+      sts = rts.similarity_join(space_name, buffers, density_ub, metric_lb);
+      if (sdm_error(sts)) {
+        std::cerr << "failed to join space: " << sts << " for space: " << space_name << std::endl;
+        return 9;
       }
 
+      std::size_t n = 0;
+      for (auto& b: buffers) n += b.size();
+      triplets.reserve(n);
+      for (auto& b: buffers)
+        for (auto& e: b) {
+          // geometry and join may see different cardinalities if the space grew
+          if (e.i < g.size() && e.j < g.size())
+            triplets.push_back(triplet(e.i, e.j, e.similarity)); // XXX could try overlap metric
+        }
+      std::cout << n << " pairs" << std::endl;
+
       // create sparse matrix from triplets
       sparse_matrix A(feature_map.size(), feature_map.size());
       A.setFromTriplets(triplets.begin(), triplets.end());
@@ -0,0 +1,203 @@
+/***************************************************************************
+ * ann_bench - recall and latency of approximate topology queries against
+ *             exact get_topology for a space
+ *
+ * See: LICENSE for conditions under which this software is published.
+ ***************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/program_options.hpp>
+
+// local includes
+#include "../rtl/database.hpp"
+
+
+#define B2MB(b_) ((double)(b_)/(1024*1024))
+
+using namespace sdm;
+
+typedef std::chrono::steady_clock bench_clock;
+
+inline double micros(const bench_clock::time_point& from) {
+  return std::chrono::duration<double, std::micro>(bench_clock::now() - from).count();
+}
+
+
+////////////////////////////////
+// entry point and command line
+
+int main(const int argc, const char** argv) {
+
+  namespace po = boost::program_options;
+
+  // command line options
+
+  std::size_t initial_size;
+  std::size_t maximum_size;
+  std::size_t n_queries;
+  std::size_t k;
+  unsigned links;
+  unsigned ef_construction;
+  unsigned lsh_tables;
+  unsigned lsh_bits;
+  unsigned partitions;
+  double metric_lb;
+  std::string efforts;
+  std::string space_name;
+
+  po::options_description desc("Allowed options");
+  po::positional_options_description p;
+  p.add("heapimage", -1);
+
+  desc.add_options()
+    ("help", "SDM approximate topology benchmark")
+    ("heapsize", po::value<std::size_t>(&initial_size)->default_value(700),
+     "initial size of heap in Mbytes")
+    ("maxheap", po::value<std::size_t>(&maximum_size)->default_value(700),
+     "maximum size of heap in Mbytes")
+    ("heapimage", po::value<std::string>(),
+     "heap image name (should be a valid path)")
+    ("space", po::value<std::string>(&space_name)->default_value("words"),
+     "name of space to query")
+    ("queries", po::value<std::size_t>(&n_queries)->default_value(200),
+     "number of symbols of the space to use as queries")
+    ("k", po::value<std::size_t>(&k)->default_value(20),
+     "number of neighbours wanted")
+    ("metric_min", po::value<double>(&metric_lb)->default_value(0.0),
+     "minimum value of metric")
+    ("effort", po::value<std::string>(&efforts)->default_value("20,40,80,160,320"),
+     "comma separated per query efforts (hnsw ef, ivf or lsh probes) to try")
+    ("build", po::value<unsigned>(&links)->default_value(0),
+     "build an hnsw graph with this many links per node first")
+    ("ef_construction", po::value<unsigned>(&ef_construction)->default_value(200),
+     "hnsw ef when building")
+    ("lsh", po::value<unsigned>(&lsh_tables)->default_value(0),
+     "build an lsh with this many tables first")
+    ("lsh_bits", po::value<unsigned>(&lsh_bits)->default_value(32),
+     "bits sampled per lsh table")
+    ("ivf", po::value<unsigned>(&partitions)->default_value(0),
+     "build an inverted file with this many partitions first")
+    ("sketch", "two stage search of the snapshot sketches taking effort as the shortlist instead of an index");
+
+  po::variables_map opts;
+  po::store(po::command_line_parser(argc, argv).options(desc).positional(p).run(), opts);
+  po::notify(opts);
+
+  if (opts.count("help")) {
+    std::cout << desc <<  std::endl;
+    return 1;
+  } else if (!opts.count("heapimage")) {
+    std::cout << "heap image file is required!" << std::endl;
+    return 3;
+  }
+
+  std::string heapfile(opts["heapimage"].as<std::string>());
+  database rts(heapfile, initial_size * 1024 * 1024, maximum_size * 1024 * 1024);
+
+  auto r = rts.get_space_cardinality(space_name);
+  if (sdm_error(r.first) || r.second == 0) {
+    std::cerr << "failed to find space: " << r.first << " for space: " << space_name << std::endl;
+    return 5;
+  }
+  std::cout << space_name << " cardinality: " << r.second << std::endl;
+
+  if (links > 0) {
+    auto start = bench_clock::now();
+    sdm_status_t sts = rts.build_hnsw(space_name, links, ef_construction);
+    if (sdm_error(sts)) {
+      std::cerr << "failed to build graph: " << sts << std::endl;
+      return 7;
+    }
+    std::cout << "built graph in " << micros(start) / 1e6 << "s" << std::endl;
+  }
+
+  if (lsh_tables > 0) {
+    auto start = bench_clock::now();
+    sdm_status_t sts = rts.build_lsh(space_name, lsh_tables, lsh_bits);
+    if (sdm_error(sts)) {
+      std::cerr << "failed to build lsh: " << sts << std::endl;
+      return 7;
+    }
+    std::cout << "built lsh in " << micros(start) / 1e6 << "s" << std::endl;
+  }
+
+  if (partitions > 0) {
+    auto start = bench_clock::now();
+    sdm_status_t sts = rts.build_ivf(space_name, partitions);
+    if (sdm_error(sts)) {
+      std::cerr << "failed to build inverted file: " << sts << std::endl;
+      return 7;
+    }
+    std::cout << "built inverted file in " << micros(start) / 1e6 << "s" << std::endl;
+  }
+
+  // query vectors spread over the space
+  database::geometry g;
+  rts.get_geometry(space_name, g);
+  const std::size_t stride = std::max<std::size_t>(1, g.size() / n_queries);
+  std::vector<std::vector<SDM_VECTOR_ELEMENT_TYPE>> queries;
+  for (std::size_t i = 0; i < g.size() && queries.size() < n_queries; i += stride) {
+    std::vector<SDM_VECTOR_ELEMENT_TYPE> v(SDM_VECTOR_ELEMS);
+    rts.load_vector(space_name, g[i].name, v.data());
+    queries.push_back(v);
+  }
+
+  // exact answers -- similarity of the kth neighbour so that ties
+  // broken differently still count as recalled
+  std::vector<std::size_t> exact;
+  std::vector<double> kth;
+  auto start = bench_clock::now();
+  for (auto& q: queries) {
+    database::topology t;
+    rts.get_topology(space_name, *reinterpret_cast<const sdm_vector_t*>(q.data()), t, 1.0, metric_lb, k);
+    exact.push_back(t.size());
+    kth.push_back(t.empty() ? 0 : t.back().similarity);
+  }
+  std::cout << "exact: " << std::fixed << std::setprecision(1)
+            << micros(start) / queries.size() << "us/query" << std::endl;
+
+  // approximate answers at each effort
+  std::vector<std::string> levels;
+  boost::split(levels, efforts, boost::is_any_of(","));
+
+  std::cout << std::setw(8) << "effort" << std::setw(10) << "recall" << std::setw(14) << "us/query" << std::endl;
+
+  for (auto& level: levels) {
+    const std::size_t effort = std::stoul(level);
+    std::size_t hits = 0, wanted = 0;
+    double elapsed = 0;
+
+    for (std::size_t i = 0; i < queries.size(); ++i) {
+      database::topology t;
+      auto start = bench_clock::now();
+      const sdm_vector_t& q = *reinterpret_cast<const sdm_vector_t*>(queries[i].data());
+      sdm_status_t sts = opts.count("sketch")
+        ? rts.get_topology_sketched(space_name, q, t, 1.0, metric_lb, k, effort)
+        : rts.get_topology_approx(space_name, q, t, 1.0, metric_lb, k, effort);
+      elapsed += micros(start);
+      if (sdm_error(sts)) {
+        std::cerr << "no approximate index for space: " << space_name << " (try --build, --ivf or --lsh)" << std::endl;
+        return 9;
+      }
+      std::size_t found = 0;
+      for (auto& n: t) if (n.similarity >= kth[i] - 1e-12) ++found;
+      hits += std::min(found, exact[i]);
+      wanted += exact[i];
+    }
+
+    std::cout << std::setw(8) << effort
+              << std::setw(10) << std::setprecision(4) << (wanted ? double(hits) / wanted : 1.0)
+              << std::setw(14) << std::setprecision(1) << elapsed / queries.size() << std::endl;
+  }
+
+  std::cout << heapfile << ": " << (rts.check_heap_sanity() ? "✔" : "✘")
+            << " heap size: "   << B2MB(rts.heap_size())
+            << " free: "        << B2MB(rts.free_heap()) << std::endl;
+  return 0;
+}
@@ -120,6 +120,8 @@ int main(int argc, const char** argv) {
   bool refcount = false;
   // lines start with frame ids to group frames else assume 1 line/frame
   bool frameids = false;
+  // co-train each term with the whole frame at once (symmetric only)
+  bool bundle = false;
 
   // default space names
   string framespace;
@@ -145,6 +147,8 @@ int main(int argc, const char** argv) {
      "co-train terms in termspace")
     ("symmetric", po::bool_switch(&symmetric),
      "aRb => bRA")
+    ("bundle", po::bool_switch(&bundle),
+     "co-train each term with the rest of its frame in one pass (symmetric only)")
     ("termspace", po::value<string>(),
      "name of space for terms")
     ("framespace", po::value<string>(),
@@ -191,6 +195,12 @@ int main(int argc, const char** argv) {
 
   string heapfile(opts["image"].as<string>());
 
+  // bundling is only the same as pairwise training for an unshifted symmetric relation
+  if (bundle && (!cotrain || !symmetric || diffterms)) {
+    cout << "Warning: bundle needs cotrain and symmetric without multisense -- training pairwise!" << endl;
+    bundle = false;
+  }
+
   // warn user maybe they just want to parse the input...
   if (!reverse_index && !cotrain) {
     cout << "Warning: not co-training terms and no framespace given so no training effects!" << endl;
@@ -204,6 +214,7 @@ int main(int argc, const char** argv) {
   cout << "termspace:  " << termspace                             << endl;
   cout << "framespace: " << (reverse_index ? framespace : "None") << endl;
   cout << "symmetric:  " << symmetric                             << endl;
+  cout << "bundle:     " << bundle                                << endl;
   cout << "cotrain:    " << cotrain                               << endl;
   cout << "multisense: " << diffterms                             << endl;
   cout << "refcount:   " << refcount                              << endl;
@@ -280,21 +291,30 @@ int main(int argc, const char** argv) {
       
       list<string> termset(tv.begin()+start, tv.end());
 
-      // assert reverse index if required
-      if (reverse_index) for (string term: termset) {
-          db.superpose(framespace, frameid, termspace, term, diffterms);
+      // resolve each term once for the frame rather than per pair
+      vector<sdm_handle_t> terms;
+      if (reverse_index || cotrain) for (string term: termset) {
+        auto h = db.ensure_handle(termspace, term);
+        if (!sdm_error(h.first)) terms.push_back(h.second);
+      }
+
+      // assert reverse index if required -- all the terms at once
+      if (reverse_index) {
+        auto frame = db.ensure_handle(framespace, frameid);
+        if (!sdm_error(frame.first)) db.superpose(frame.second, terms);
       }
 
-      // cotrain terms in termspace
-      if (cotrain) {
+      // cotrain terms in termspace -- bundled a term at a time
+      if (bundle) db.bundle(terms);
+      else if (cotrain) {
         // co-train pairwise combinatations of terms
         // XXX the triangular optimization only makes sense if relation is symmetric. XXX
-        for (auto first = termset.begin(); first != termset.end(); ++first) {
-          for (auto next = std::next(first); next != termset.end(); ++next) {
+        for (auto first = terms.begin(); first != terms.end(); ++first) {
+          for (auto next = std::next(first); next != terms.end(); ++next) {
             // assert: first R next
-            db.superpose(termspace, *first, termspace, *next, diffterms);
+            db.superpose(*first, *next, diffterms);
             // if aRb => bRa then reify next R first
-            if (symmetric) db.superpose(termspace, *next, termspace, *first);
+            if (symmetric) db.superpose(*next, *first);
           }
         }
       }
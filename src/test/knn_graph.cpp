@@ -0,0 +1,189 @@
+/***************************************************************************
+ * knn_graph - approximate k nearest neighbour affinity matrix for a space
+ *             by nn-descent, with recall against exact topology for a
+ *             sample of its points
+ *
+ * See: LICENSE for conditions under which this software is published.
+ ***************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+
+#include <boost/program_options.hpp>
+
+// local includes
+#include "../rtl/database.hpp"
+#include "index_bimap.hpp"
+#include "sparse_matrix.hpp"
+#include "sparse_matrix_io.hpp"
+
+
+#define B2MB(b_) ((double)(b_)/(1024*1024))
+
+using namespace sdm;
+
+typedef std::chrono::steady_clock bench_clock;
+
+inline double seconds(const bench_clock::time_point& from) {
+  return std::chrono::duration<double>(bench_clock::now() - from).count();
+}
+
+
+////////////////////////////////
+// entry point and command line
+
+int main(const int argc, const char** argv) {
+
+  namespace po = boost::program_options;
+
+  // command line options
+
+  std::size_t initial_size;
+  std::size_t maximum_size;
+  std::size_t k;
+  std::size_t pool;
+  unsigned rounds;
+  std::uint64_t seed;
+  double rho;
+  double delta;
+  double metric_lb;
+  std::size_t n_samples;
+  std::string space_name;
+
+  po::options_description desc("Allowed options");
+  po::positional_options_description p;
+  p.add("heapimage", -1);
+
+  desc.add_options()
+    ("help", "SDM approximate affinity matrix")
+    ("heapsize", po::value<std::size_t>(&initial_size)->default_value(700),
+     "initial size of heap in Mbytes")
+    ("maxheap", po::value<std::size_t>(&maximum_size)->default_value(700),
+     "maximum size of heap in Mbytes")
+    ("heapimage", po::value<std::string>(),
+     "heap image name (should be a valid path)")
+    ("space", po::value<std::string>(&space_name)->default_value("words"),
+     "name of space to extract topology")
+    ("k", po::value<std::size_t>(&k)->default_value(20),
+     "number of neighbours of each point")
+    ("pool", po::value<std::size_t>(&pool)->default_value(0),
+     "neighbours kept while building of which the best k are used (0 for twice k)")
+    ("rounds", po::value<unsigned>(&rounds)->default_value(12),
+     "most nn-descent rounds")
+    ("seed", po::value<std::uint64_t>(&seed)->default_value(0),
+     "random seed -- the same seed gives the same graph")
+    ("rho", po::value<double>(&rho)->default_value(0.5),
+     "fraction of neighbours sampled each round")
+    ("delta", po::value<double>(&delta)->default_value(0.001),
+     "stop once fewer than this fraction of neighbours change")
+    ("metric_min", po::value<double>(&metric_lb)->default_value(0.0),
+     "minimum value of metric")
+    ("samples", po::value<std::size_t>(&n_samples)->default_value(100),
+     "number of points to check against exact topology (0 for none)");
+
+  po::variables_map opts;
+  po::store(po::command_line_parser(argc, argv).options(desc).positional(p).run(), opts);
+  po::notify(opts);
+
+  if (opts.count("help")) {
+    std::cout << desc <<  std::endl;
+    return 1;
+  } else if (!opts.count("heapimage")) {
+    std::cout << "heap image file is required!" << std::endl;
+    return 3;
+  }
+
+  std::string heapfile(opts["heapimage"].as<std::string>());
+  database rts(heapfile, initial_size * 1024 * 1024, maximum_size * 1024 * 1024);
+
+  auto r = rts.get_space_cardinality(space_name);
+  if (sdm_error(r.first)) {
+    std::cerr << "failed to find space: " << r.first << " for space: " << space_name << std::endl;
+    return 5;
+  }
+  std::cout << space_name << " cardinality: " << r.second << std::endl;
+
+  database::geometry g;
+  g.reserve(r.second);
+  sdm_status_t sts = rts.get_geometry(space_name, g);
+  if (sdm_error(sts)) {
+    std::cerr << "failed to get geometry: " << sts << " for space: " << space_name << std::endl;
+    return 7;
+  }
+
+  // approximate neighbours of every point -- similarities are packed
+  // close together in sparse spaces so descent with lists of only k
+  // settles early and a wider pool is kept while building
+  auto start = bench_clock::now();
+  std::vector<std::vector<database::join_entry>> graph;
+  sts = rts.knn_graph(space_name, graph, std::max(k, pool ? pool : 2 * k), rounds, seed, rho, delta);
+  if (sdm_error(sts)) {
+    std::cerr << "failed to build graph: " << sts << " for space: " << space_name << std::endl;
+    return 9;
+  }
+  for (auto& l: graph) if (l.size() > k) l.resize(k);
+  std::cout << "built graph in " << std::fixed << std::setprecision(2) << seconds(start) << "s" << std::endl;
+
+  // recall against exact topology of points spread over the space --
+  // neighbours as near as the exact kth count so ties are not misses
+  if (n_samples > 0 && !g.empty()) {
+    start = bench_clock::now();
+    const std::size_t stride = std::max<std::size_t>(1, g.size() / n_samples);
+    std::size_t hits = 0, wanted = 0;
+    for (std::size_t i = 0; i < g.size() && i / stride < n_samples; i += stride) {
+      database::topology t;
+      sts = rts.get_topology(space_name, space_name, g[i].name, t, 1.0, 0.0, k + 1);
+      if (sdm_error(sts)) {
+        std::cerr << "failed to get topology: " << sts << " for point: " << g[i].name << std::endl;
+        return 9;
+      }
+      t.erase(std::remove_if(t.begin(), t.end(),
+                             [&](const database::neighbour& n) { return n.name == g[i].name; }), t.end());
+      if (t.size() > k) t.erase(t.begin() + k, t.end());
+      if (t.empty()) continue;
+
+      std::size_t found = 0;
+      for (auto& e: graph[i]) if (e.similarity >= t.back().similarity - 1e-12) ++found;
+      hits += std::min(found, t.size());
+      wanted += t.size();
+    }
+    std::cout << "recall@" << k << ": " << std::setprecision(4) << (wanted ? double(hits) / wanted : 1.0)
+              << " (exact baseline in " << std::setprecision(2) << seconds(start) << "s)" << std::endl;
+  }
+
+  // same outputs as affinity: features in geometry order with each
+  // point its own neighbour
+  index_bimap<std::string> feature_map;
+  for (auto& p: g) feature_map.ensure(p.name);
+
+  triplet_vec triplets;
+  triplets.reserve(g.size() * (k + 1));
+  for (std::size_t i = 0; i < g.size() && i < graph.size(); ++i) {
+    triplets.push_back(triplet(i, i, 1.0));
+    for (auto& e: graph[i])
+      if (e.j < g.size() && e.similarity >= metric_lb) triplets.push_back(triplet(e.i, e.j, e.similarity));
+  }
+
+  sparse_matrix A(feature_map.size(), feature_map.size());
+  A.setFromTriplets(triplets.begin(), triplets.end());
+
+  {
+    std::ofstream idxf(space_name + ".idx");
+    if (idxf.good() && feature_map.serialize(idxf))
+      idxf.close();
+  }
+
+  {
+    std::ofstream matf(space_name + ".mat");
+    if (matf.good() && serialize_matrix(A, matf))
+      matf.close();
+  }
+
+  std::cout << heapfile << ": " << (rts.check_heap_sanity() ? "✔" : "✘")
+            << " heap size: "   << B2MB(rts.heap_size())
+            << " free: "        << B2MB(rts.free_heap()) << std::endl;
+  return 0;
+}
@@ -6,6 +6,8 @@
  ***************************************************************************/
 #include <cstdio>
 #include <iostream>
+#include <map>
+#include <set>
 #include <boost/algorithm/string.hpp>
 #include <boost/interprocess/managed_mapped_file.hpp>
 
@@ -13,10 +15,11 @@
 #define BOOST_TEST_MODULE mms-0
 #include <boost/test/included/unit_test.hpp>
 #include "mms/symbol_space.hpp"
+#include "mms/nn_descent.hpp"
 
 namespace bip = boost::interprocess;
     
-const std::size_t requested_size = 2 * 1024 * 1024; // bytes
+const std::size_t requested_size = 16 * 1024 * 1024; // bytes
 const std::string tablename = "woobongaruru";
 const std::string heapfile = "vpsace-0.img";
 const std::string v0 = "vector-0";
@@ -67,6 +70,510 @@ BOOST_AUTO_TEST_CASE(insert_vector) {
   BOOST_REQUIRE(mms.get_symbol_by_name(v0));
 }
 
+
+BOOST_AUTO_TEST_CASE(search_snapshot) {
+  std::vector<unsigned> basis;
+  for (unsigned i = 0; i < 16; ++i) basis.push_back(i * 1000);
+  
+  mms.insert_symbol("a", basis);
+  mms.insert_symbol("b", basis);
+
+  BOOST_CHECK_EQUAL(mms.snapshot().rows(), 2);
+  BOOST_CHECK_EQUAL(mms.snapshot().count(0), 0);
+
+  // learning through the space patches the row
+  mms.superpose(mms.symbol_at(0), mms[1]);
+  auto& snap = mms.snapshot();
+  BOOST_CHECK_EQUAL(snap.count(0), mms[0].count());
+  BOOST_CHECK(std::equal(mms[0].vector().begin(), mms[0].vector().end(), snap.row(0)));
+  BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(snap.row(1)) % 64, 0);
+
+  // sketches sample the row words and follow learning too
+  typedef space_t::snapshot_t snapshot_t;
+  for (std::size_t w = 0; w < snapshot_t::sketch_words; ++w)
+    BOOST_CHECK_EQUAL(snap.sketch(0)[w], snap.row(0)[w * snapshot_t::sketch_stride]);
+
+  // new symbols are appended and touched rows patched
+  mms.insert_symbol("c", basis);
+  mms.symbol_at(2).superpose(mms[0]);
+  mms.touch(mms[2]);
+  BOOST_CHECK_EQUAL(mms.snapshot().rows(), 3);
+  BOOST_CHECK_EQUAL(mms.snapshot().count(2), mms[2].count());
+  BOOST_CHECK(mms.snapshot().count(2) > 0);
+  std::vector<space_t::symbol_t::element_t> sketch(snapshot_t::sketch_words);
+  snapshot_t::sketch_of(mms.snapshot().row(2), sketch.data());
+  BOOST_CHECK(std::equal(sketch.begin(), sketch.end(), mms.snapshot().sketch(2)));
+  BOOST_CHECK(std::any_of(sketch.begin(), sketch.end(), [](space_t::symbol_t::element_t w) { return w != 0; }));
+}
+
+
+BOOST_AUTO_TEST_CASE(batch_superpose) {
+  // overlapping bases, some dithered so that later sources clear bits
+  // earlier ones set
+  std::vector<const space_t::symbol_t*> sources;
+  std::vector<int> rotations;
+  for (unsigned i = 0; i < 12; ++i) {
+    std::vector<unsigned> basis;
+    for (unsigned j = 0; j < 16; ++j) basis.push_back((i * 5 + j * 3) % 64 + (j % 4) * 1000);
+    mms.insert_symbol("s" + std::to_string(i), basis, (i % 3) ? 1.0 : 0.5);
+    rotations.push_back(i % 4 ? 0 : int(i));
+  }
+  mms.insert_symbol("one", std::vector<unsigned>(16, 0));
+  mms.insert_symbol("all", std::vector<unsigned>(16, 0));
+  for (unsigned i = 0; i < 12; ++i) sources.push_back(&mms[i]);
+
+  for (auto rotated: {false, true}) {
+    for (unsigned i = 0; i < 12; ++i) mms.superpose(mms.symbol_at(12), mms[i], rotated ? rotations[i] : 0);
+    mms.superpose(mms.symbol_at(13), sources.data(), sources.size(), rotated ? rotations.data() : nullptr);
+
+    BOOST_CHECK(std::equal(mms[12].vector().begin(), mms[12].vector().end(), mms[13].vector().begin()));
+    BOOST_CHECK(mms[13].count() > 0);
+    BOOST_CHECK_EQUAL(mms.snapshot().count(13), mms[13].count());
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(bundle) {
+  // two copies of a frame of overlapping bases, some dithered: one is
+  // co-trained pairwise and the other bundled
+  const unsigned n = 10;
+  for (auto copy: {"p", "b"})
+    for (unsigned i = 0; i < n; ++i) {
+      std::vector<unsigned> basis;
+      for (unsigned j = 0; j < 16; ++j) basis.push_back((i * 5 + j * 3) % 64 + (j % 4) * 1000);
+      mms.insert_symbol(copy + std::to_string(i), basis, (i % 3) ? 1.0 : 0.5);
+    }
+  BOOST_REQUIRE(mms.build_postings());
+
+  for (unsigned i = 0; i < n; ++i)
+    for (unsigned j = i + 1; j < n; ++j) {
+      mms.superpose(mms.symbol_at(i), mms[j]);
+      mms.superpose(mms.symbol_at(j), mms[i]);
+    }
+  std::vector<space_t::symbol_t*> frame;
+  for (unsigned i = 0; i < n; ++i) frame.push_back(&mms.symbol_at(n + i));
+  mms.bundle(frame.data(), frame.size());
+
+  for (unsigned i = 0; i < n; ++i) {
+    BOOST_CHECK(std::equal(mms[i].vector().begin(), mms[i].vector().end(), mms[n + i].vector().begin()));
+    BOOST_CHECK(mms[n + i].count() > 0);
+    BOOST_CHECK_EQUAL(mms.snapshot().count(n + i), mms[n + i].count());
+  }
+
+  // postings follow the bundled vectors
+  for (unsigned i = 0; i < n; ++i) {
+    std::vector<std::pair<std::size_t, std::size_t>> hits;
+    BOOST_REQUIRE(mms.basis_overlap(mms[i].basis(), 0, 1, hits));
+    for (auto& h: hits) {
+      std::size_t held = 0;
+      for (auto b: mms[i].basis()) held += (mms[h.first].vector().words()[b / 64] >> (b % 64)) & 1;
+      BOOST_CHECK_EQUAL(h.second, held);
+    }
+  }
+
+  // a term repeated in the frame takes its own basis too
+  std::vector<unsigned> basis(16, 0);
+  for (unsigned i = 0; i < 16; ++i) basis[i] = i * 1000 + 7;
+  BOOST_REQUIRE(mms.insert_symbol("x", basis));
+  for (unsigned i = 0; i < 16; ++i) basis[i] = i * 1000 + 9;
+  BOOST_REQUIRE(mms.insert_symbol("y", basis));
+  std::vector<space_t::symbol_t*> twice = {&mms.symbol_at(2 * n), &mms.symbol_at(2 * n + 1), &mms.symbol_at(2 * n)};
+  mms.bundle(twice.data(), twice.size());
+  BOOST_CHECK_EQUAL(mms[2 * n].count(), 32);
+  BOOST_CHECK_EQUAL(mms[2 * n + 1].count(), 16);
+}
+
+
+BOOST_AUTO_TEST_CASE(prefix_pages) {
+  std::vector<unsigned> basis;
+  for (unsigned i = 0; i < 16; ++i) basis.push_back(i * 1000);
+
+  // inserted out of name order around a namespace
+  for (unsigned i = 0; i < 250; ++i) {
+    const unsigned j = (i * 37) % 250;
+    mms.insert_symbol("ns/" + std::to_string(1000 + j), basis);
+    if (j % 5 == 0) mms.insert_symbol("nt/" + std::to_string(j), basis);
+  }
+  mms.insert_symbol("n", basis);
+
+  BOOST_CHECK_EQUAL(mms.count_prefix("ns/"), 250);
+  BOOST_CHECK_EQUAL(mms.count_prefix("nt/"), 50);
+  BOOST_CHECK_EQUAL(mms.count_prefix("ns/11"), 100);
+  BOOST_CHECK_EQUAL(mms.count_prefix("n"), 301);
+  BOOST_CHECK_EQUAL(mms.count_prefix(""), mms.entries());
+  BOOST_CHECK_EQUAL(mms.count_prefix("zz"), 0);
+
+  // pages of 32 by cursor cover the range once in name order
+  std::vector<std::string> names;
+  std::size_t cursor = 0;
+  for (;;) {
+    auto page = mms.prefix_page("ns/", cursor, 32);
+    const std::size_t n = std::distance(page.first, page.second);
+    BOOST_CHECK(n <= 32);
+    if (n == 0) break;
+    for (auto i = page.first; i != page.second; ++i) names.push_back(i->name());
+    cursor += n;
+  }
+  BOOST_CHECK_EQUAL(names.size(), 250);
+  BOOST_CHECK(std::is_sorted(names.begin(), names.end()));
+  BOOST_CHECK_EQUAL(names.front(), "ns/1000");
+  BOOST_CHECK_EQUAL(names.back(), "ns/1249");
+
+  // a page beyond the range is empty
+  auto past = mms.prefix_page("nt/", 50, 10);
+  BOOST_CHECK(past.first == past.second);
+}
+
+
+BOOST_AUTO_TEST_CASE(multi_index_hash) {
+  // pairs of symbols trained on nearly the same sources
+  const unsigned n = 200;
+  for (unsigned i = 0; i < n; ++i) {
+    std::vector<unsigned> basis;
+    for (unsigned j = 0; j < 16; ++j) basis.push_back((i * 7919 + j * 1021) % 16384);
+    BOOST_REQUIRE(mms.insert_symbol("s" + std::to_string(i), basis));
+  }
+
+  BOOST_CHECK(!mms.build_mih(3));
+  BOOST_REQUIRE(mms.build_mih(32));
+  BOOST_CHECK_EQUAL(mms.mih_tables(), 32);
+
+  auto train = [&](unsigned from) {
+    for (unsigned i = from; i < n; ++i)
+      for (unsigned j = 0; j < 40 + (i % 2); ++j)
+        mms.superpose(mms.symbol_at(i), mms[(i / 2 * 13 + j) % n]);
+  };
+
+  // every symbol within the radius must be a candidate
+  auto exact = [&]() {
+    for (unsigned q = 0; q < n; q += 17) {
+      auto v = mms[q].vector();
+      for (std::size_t radius: {0, 10, 31, 32, 63}) {
+        std::vector<std::size_t> ids;
+        BOOST_REQUIRE(mms.mih_candidates(v, radius, n * 64, ids));
+        for (unsigned i = 0; i < n; ++i)
+          if (mms[i].vector().distance(v) <= radius)
+            BOOST_CHECK(std::binary_search(ids.begin(), ids.end(), i));
+      }
+      std::vector<std::size_t> ids;
+      BOOST_CHECK(!mms.mih_candidates(v, 64, n * 64, ids));
+      BOOST_CHECK(!mms.mih_candidates(v, 0, 1, ids));
+    }
+  };
+
+  train(0);
+  exact();
+
+  // maintained on update and insert
+  train(n / 2);
+  std::vector<unsigned> basis(16, 5);
+  mms.insert_symbol("late", basis);
+  exact();
+  std::vector<std::size_t> ids;
+  BOOST_CHECK(mms.mih_candidates(mms[n].vector(), 0, n * 64, ids));
+  BOOST_CHECK(std::binary_search(ids.begin(), ids.end(), n));
+
+  // persists in the image
+  space_t again(tablename, segment);
+  BOOST_CHECK_EQUAL(again.mih_tables(), 32);
+}
+
+
+BOOST_AUTO_TEST_CASE(hnsw_graph) {
+  const unsigned n = 1500;
+  for (unsigned i = 0; i < n; ++i) {
+    std::vector<unsigned> basis;
+    for (unsigned j = 0; j < 16; ++j) basis.push_back((i * 7919 + j * 1021) % 16384);
+    BOOST_REQUIRE(mms.insert_symbol("s" + std::to_string(i), basis));
+  }
+
+  // clusters with some noise
+  for (unsigned i = 0; i < n; ++i)
+    for (unsigned j = 0; j < 12; ++j)
+      mms.superpose(mms.symbol_at(i), mms[(j < 8) ? (i % 40) * 31 + j : (i * 13 + j * 101) % n]);
+
+  BOOST_CHECK(!mms.build_hnsw(1, 100));
+  BOOST_REQUIRE(mms.build_hnsw(12, 100));
+  BOOST_CHECK_EQUAL(mms.hnsw_degree(), 12);
+
+  // tie tolerant recall at 10
+  auto recall = [&](std::size_t ef) {
+    std::size_t hits = 0, wanted = 0;
+    for (unsigned q = 0; q < n; q += 37) {
+      auto v = mms[q].vector();
+      std::vector<std::size_t> d;
+      for (unsigned i = 0; i < mms.entries(); ++i) d.push_back(mms[i].vector().distance(v));
+      std::vector<std::size_t> sorted(d);
+      std::sort(sorted.begin(), sorted.end());
+      const std::size_t kth = sorted[9];
+
+      std::vector<std::size_t> ids;
+      BOOST_REQUIRE(mms.hnsw_candidates(v, ef, ids));
+      std::size_t found = 0;
+      for (auto i: ids) if (d[i] <= kth) ++found;
+      hits += std::min<std::size_t>(found, 10);
+      wanted += 10;
+    }
+    return double(hits) / wanted;
+  };
+
+  BOOST_CHECK(recall(10) > 0.7);
+  BOOST_CHECK(recall(100) > 0.95);
+
+  // changed symbols are candidates before and after they are linked
+  for (unsigned i = 0; i < 5; ++i) mms.superpose(mms.symbol_at(i), mms[n - 1 - i]);
+  std::vector<std::size_t> ids;
+  BOOST_REQUIRE(mms.hnsw_candidates(mms[3].vector(), 10, ids));
+  BOOST_CHECK(std::binary_search(ids.begin(), ids.end(), 3));
+  for (unsigned i = 0; i < 300; ++i) mms.superpose(mms.symbol_at(i), mms[i + 1]);
+  BOOST_CHECK(recall(100) > 0.95);
+
+  // persists in the image
+  space_t again(tablename, segment);
+  BOOST_CHECK_EQUAL(again.hnsw_degree(), 12);
+}
+
+BOOST_AUTO_TEST_CASE(lsh_index) {
+  const unsigned n = 1000;
+  for (unsigned i = 0; i < n; ++i) {
+    std::vector<unsigned> basis;
+    for (unsigned j = 0; j < 16; ++j) basis.push_back((i * 7919 + j * 1021) % 16384);
+    BOOST_REQUIRE(mms.insert_symbol("s" + std::to_string(i), basis));
+  }
+
+  // clusters with some noise
+  for (unsigned i = 0; i < n; ++i)
+    for (unsigned j = 0; j < 12; ++j)
+      mms.superpose(mms.symbol_at(i), mms[(j < 8) ? (i % 25) * 31 + j : (i * 13 + j * 101) % n]);
+
+  BOOST_CHECK(!mms.build_lsh(0, 16));
+  BOOST_CHECK(!mms.build_lsh(8, 65));
+  BOOST_REQUIRE(mms.build_lsh(16, 32));
+  BOOST_CHECK_EQUAL(mms.lsh_tables(), 16);
+
+  // tie tolerant recall at 10 of the candidates
+  auto recall = [&](std::size_t probes) {
+    std::size_t hits = 0, wanted = 0;
+    for (unsigned q = 0; q < n; q += 37) {
+      auto v = mms[q].vector();
+      std::vector<std::size_t> d;
+      for (unsigned i = 0; i < mms.entries(); ++i) d.push_back(mms[i].vector().distance(v));
+      std::vector<std::size_t> sorted(d);
+      std::sort(sorted.begin(), sorted.end());
+      const std::size_t kth = sorted[9];
+
+      std::vector<std::size_t> ids;
+      BOOST_REQUIRE(mms.lsh_candidates(v, probes, n * 16 * 64, ids));
+      BOOST_CHECK(std::is_sorted(ids.begin(), ids.end()));
+      std::size_t found = 0;
+      for (auto i: ids) if (d[i] <= kth) ++found;
+      hits += std::min<std::size_t>(found, 10);
+      wanted += 10;
+    }
+    return double(hits) / wanted;
+  };
+
+  const double plain = recall(0);
+  const double probed = recall(32);
+  BOOST_CHECK(plain > 0.5);
+  BOOST_CHECK(probed >= plain);
+  BOOST_CHECK(probed > 0.9);
+
+  // too many to visit
+  std::vector<std::size_t> ids;
+  BOOST_CHECK(!mms.lsh_candidates(mms[0].vector(), 32, 1, ids));
+
+  // refiled as symbols change: a changed symbol shares every key with
+  // its new vector
+  for (unsigned j = 0; j < 30; ++j) mms.superpose(mms.symbol_at(7), mms[500]);
+  ids.clear();
+  BOOST_REQUIRE(mms.lsh_candidates(mms[7].vector(), 0, n * 16, ids));
+  BOOST_CHECK(std::binary_search(ids.begin(), ids.end(), 7));
+  BOOST_CHECK(recall(32) > 0.9);
+
+  // persists in the image
+  space_t again(tablename, segment);
+  BOOST_CHECK_EQUAL(again.lsh_tables(), 16);
+}
+
+BOOST_AUTO_TEST_CASE(ivf_index) {
+  const unsigned n = 1000;
+  for (unsigned i = 0; i < n; ++i) {
+    std::vector<unsigned> basis;
+    for (unsigned j = 0; j < 16; ++j) basis.push_back((i * 7919 + j * 1021) % 16384);
+    BOOST_REQUIRE(mms.insert_symbol("s" + std::to_string(i), basis));
+  }
+
+  // clusters with some noise
+  for (unsigned i = 0; i < n; ++i)
+    for (unsigned j = 0; j < 12; ++j)
+      mms.superpose(mms.symbol_at(i), mms[(j < 8) ? (i % 25) * 31 + j : (i * 13 + j * 101) % n]);
+
+  BOOST_CHECK(!mms.build_ivf(0, 4));
+  BOOST_REQUIRE(mms.build_ivf(25, 6));
+  BOOST_CHECK_EQUAL(mms.ivf_partitions(), 25);
+
+  // tie tolerant recall at 10 of the candidates and their share of the space
+  std::size_t scanned;
+  auto recall = [&](std::size_t nprobe) {
+    std::size_t hits = 0, wanted = 0;
+    scanned = 0;
+    for (unsigned q = 0; q < n; q += 37) {
+      auto v = mms[q].vector();
+      std::vector<std::size_t> d;
+      for (unsigned i = 0; i < mms.entries(); ++i) d.push_back(mms[i].vector().distance(v));
+      std::vector<std::size_t> sorted(d);
+      std::sort(sorted.begin(), sorted.end());
+      const std::size_t kth = sorted[9];
+
+      std::vector<std::size_t> ids;
+      BOOST_REQUIRE(mms.ivf_candidates(v, nprobe, ids));
+      BOOST_CHECK(std::is_sorted(ids.begin(), ids.end()));
+      std::size_t found = 0;
+      for (auto i: ids) if (d[i] <= kth) ++found;
+      hits += std::min<std::size_t>(found, 10);
+      wanted += 10;
+      scanned += ids.size();
+    }
+    return double(hits) / wanted;
+  };
+
+  BOOST_CHECK(recall(2) > 0.8);
+  BOOST_CHECK(scanned < 28 * n / 2);
+  BOOST_CHECK_EQUAL(recall(25), 1.0);
+  BOOST_CHECK_EQUAL(scanned, 28 * mms.entries());
+
+  // changed symbols are candidates before and after they are filed
+  for (unsigned i = 0; i < 5; ++i) mms.superpose(mms.symbol_at(i), mms[n - 1 - i]);
+  std::vector<std::size_t> ids;
+  BOOST_REQUIRE(mms.ivf_candidates(mms[3].vector(), 1, ids));
+  BOOST_CHECK(std::binary_search(ids.begin(), ids.end(), 3));
+  for (unsigned i = 0; i < 300; ++i) mms.superpose(mms.symbol_at(i), mms[i + 1]);
+  BOOST_CHECK_EQUAL(recall(25), 1.0);
+
+  // persists in the image
+  space_t again(tablename, segment);
+  BOOST_CHECK_EQUAL(again.ivf_partitions(), 25);
+}
+
+BOOST_AUTO_TEST_CASE(bit_postings) {
+  const unsigned n = 300;
+  for (unsigned i = 0; i < n; ++i) {
+    std::vector<unsigned> basis;
+    for (unsigned j = 0; j < 16; ++j) basis.push_back((i * 7919 + j * 1021) % 16384);
+    BOOST_REQUIRE(mms.insert_symbol("s" + std::to_string(i), basis));
+  }
+  for (unsigned i = 0; i < n / 2; ++i)
+    for (unsigned j = 0; j < 5; ++j) mms.superpose(mms.symbol_at(i), mms[(i * 3 + j) % n], j % 2);
+
+  BOOST_REQUIRE(mms.build_postings());
+  BOOST_CHECK(mms.has_postings());
+
+  // every posting lists exactly the symbols with its bit set
+  auto exact = [&]() {
+    std::vector<std::vector<std::size_t>> expected(16384);
+    for (unsigned i = 0; i < mms.entries(); ++i) {
+      auto v = mms[i].vector();
+      for (std::size_t b = 0; b < 16384; ++b)
+        if ((v.words()[b / 64] >> (b % 64)) & 1) expected[b].push_back(i);
+    }
+    for (unsigned i = 0; i < n; i += 7) {
+      std::vector<std::pair<std::size_t, std::size_t>> hits;
+      BOOST_REQUIRE(mms.basis_overlap(mms[i].basis(), 1, 1, hits));
+      std::map<std::size_t, std::size_t> held;
+      for (auto b: mms[i].basis())
+        for (auto id: expected[(b + 1) % 16384]) ++held[id];
+      BOOST_REQUIRE_EQUAL(hits.size(), held.size());
+      for (auto& h: hits) BOOST_CHECK_EQUAL(h.second, held[h.first]);
+    }
+  };
+  exact();
+
+  // maintained by superpose, by insert and by touch
+  for (unsigned i = n / 2; i < n; ++i)
+    for (unsigned j = 0; j < 5; ++j) mms.superpose(mms.symbol_at(i), mms[(i * 5 + j) % n], 1);
+  std::vector<unsigned> basis(16, 9);
+  mms.superpose(*mms.insert_mutable_symbol("late", basis), mms[3], 1);
+  exact();
+
+  // a symbol holds all of what it absorbed
+  std::vector<std::pair<std::size_t, std::size_t>> hits;
+  BOOST_REQUIRE(mms.basis_overlap(mms[3].basis(), 1, 16, hits));
+  BOOST_CHECK(std::find(hits.begin(), hits.end(), std::make_pair(std::size_t(n), std::size_t(16))) != hits.end());
+
+  // persists in the image
+  space_t again(tablename, segment);
+  BOOST_CHECK(again.has_postings());
+}
+
+BOOST_AUTO_TEST_CASE(nn_descent) {
+  const unsigned n = 1200;
+  for (unsigned i = 0; i < n; ++i) {
+    std::vector<unsigned> basis;
+    for (unsigned j = 0; j < 16; ++j) basis.push_back((i * 7919 + j * 1021) % 16384);
+    BOOST_REQUIRE(mms.insert_symbol("s" + std::to_string(i), basis));
+  }
+
+  // clusters with some noise
+  for (unsigned i = 0; i < n; ++i)
+    for (unsigned j = 0; j < 12; ++j)
+      mms.superpose(mms.symbol_at(i), mms[(j < 8) ? (i % 40) * 29 + j : (i * 13 + j * 101) % n]);
+
+  auto row = [&](const std::size_t i) { return mms[i].vector().words(); };
+  auto build = [&](sdm::mms::nn_descent& nn, const unsigned rounds) {
+    for (std::size_t v = 0; v < nn.size(); ++v) nn.init(v, row);
+    for (unsigned r = 0; r < rounds; ++r) {
+      nn.sample(0.5, r);
+      std::vector<sdm::mms::nn_descent::proposal> ps;
+      for (std::size_t v = 0; v < nn.size(); ++v) {
+        ps.clear();
+        nn.join(v, row, ps);
+        nn.apply(ps);
+      }
+    }
+  };
+
+  sdm::mms::nn_descent nn(mms.entries(), 256, 10, 7);
+  BOOST_CHECK_EQUAL(nn.degree(), 10);
+  build(nn, 8);
+
+  // tie tolerant recall at 10 and lists sorted without self or repeats
+  std::size_t hits = 0, wanted = 0;
+  for (unsigned q = 0; q < n; q += 37) {
+    auto v = mms[q].vector();
+    std::vector<std::size_t> d;
+    for (unsigned i = 0; i < mms.entries(); ++i) d.push_back(mms[i].vector().distance(v));
+    d[q] = ~std::size_t(0);
+    std::vector<std::size_t> sorted(d);
+    std::sort(sorted.begin(), sorted.end());
+
+    const sdm::mms::nn_descent::entry* l = nn.neighbours(q);
+    std::set<std::uint32_t> ids;
+    for (std::size_t i = 0; i < nn.degree(); ++i) {
+      BOOST_CHECK_EQUAL(l[i].distance, d[l[i].id]);
+      if (i > 0) BOOST_CHECK(!(l[i] < l[i - 1]));
+      ids.insert(l[i].id);
+      if (d[l[i].id] <= sorted[9]) ++hits;
+    }
+    BOOST_CHECK_EQUAL(ids.size(), nn.degree());
+    BOOST_CHECK(!ids.count(q));
+    wanted += 10;
+  }
+  BOOST_CHECK(double(hits) / wanted > 0.9);
+
+  // the seed fixes the graph
+  sdm::mms::nn_descent again(mms.entries(), 256, 10, 7);
+  build(again, 8);
+  for (std::size_t v = 0; v < n; ++v)
+    for (std::size_t i = 0; i < nn.degree(); ++i) BOOST_CHECK_EQUAL(nn.neighbours(v)[i].id, again.neighbours(v)[i].id);
+
+  // no more neighbours than there are other rows
+  sdm::mms::nn_descent tiny(3, 256, 10, 7);
+  build(tiny, 2);
+  BOOST_CHECK_EQUAL(tiny.degree(), 2);
+  BOOST_CHECK_EQUAL(tiny.neighbours(0)[0].id + tiny.neighbours(0)[1].id, 3);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
   
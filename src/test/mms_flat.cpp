@@ -0,0 +1,128 @@
+/***************************************************************************
+ * flat symbol layout -- aligned inline records behave like boxed symbols
+ *
+ * See: LICENSE for conditions under which this software is published.
+ ***************************************************************************/
+#include <cstdio>
+#include <cstdint>
+#include <iostream>
+#include <boost/interprocess/managed_mapped_file.hpp>
+
+#define BOOST_TEST_MODULE mms-flat
+#include <boost/test/included/unit_test.hpp>
+#include "mms/symbol_space.hpp"
+
+namespace bip = boost::interprocess;
+
+const std::size_t requested_size = 8 * 1024 * 1024; // bytes
+const std::string tablename = "flatland";
+const std::string flatfile = "vspace-flat.img";
+const std::string boxedfile = "vspace-boxed.img";
+
+typedef bip::managed_mapped_file segment_t;
+
+typedef sdm::mms::symbol_space<unsigned long, 256, 16, segment_t> boxed_space_t;
+typedef sdm::mms::symbol_space<unsigned long, 256, 16, segment_t,
+                               sdm::mms::flat_symbol> flat_space_t;
+
+
+// a basis of 16 distinct indices
+std::vector<unsigned> basis_for(unsigned seed) {
+  std::vector<unsigned> b;
+  for (unsigned i = 0; i < 16; ++i) b.push_back((seed * 7919 + i * 1031) % 16384);
+  return b;
+}
+
+
+// test context
+struct test_setup {
+  segment_t flat_segment;
+  segment_t boxed_segment;
+  flat_space_t flat;
+  boxed_space_t boxed;
+
+  test_setup() : flat_segment(bip::open_or_create, flatfile.c_str(), requested_size),
+                 boxed_segment(bip::open_or_create, boxedfile.c_str(), requested_size),
+                 flat(tablename, flat_segment),
+                 boxed(tablename, boxed_segment) {}
+
+  ~test_setup() {
+    remove(flatfile.c_str());
+    remove(boxedfile.c_str());
+  }
+};
+
+
+BOOST_FIXTURE_TEST_SUITE(mms_flat, test_setup)
+
+
+BOOST_AUTO_TEST_CASE(aligned_records) {
+  for (unsigned i = 0; i < 32; ++i)
+    BOOST_REQUIRE(flat.insert_symbol("s" + std::to_string(i), basis_for(i)));
+
+  for (unsigned i = 0; i < 32; ++i) {
+    auto v = flat[i].vector();
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(v.data()) % 64, 0);
+    BOOST_CHECK_EQUAL(v.count(), 0);
+    BOOST_CHECK_EQUAL(flat[i].basis().size(), 16);
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(layouts_agree) {
+  // same training in both layouts
+  for (unsigned i = 0; i < 8; ++i) {
+    std::string n = "s" + std::to_string(i);
+    BOOST_REQUIRE(flat.insert_symbol(n, basis_for(i), i % 2 ? 1.0 : 0.5));
+    BOOST_REQUIRE(boxed.insert_symbol(n, basis_for(i), i % 2 ? 1.0 : 0.5));
+  }
+
+  for (unsigned i = 0; i < 8; ++i) {
+    for (unsigned j = 0; j < 8; ++j) {
+      if (i == j) continue;
+      flat.symbol_at(i).superpose(flat[j], j);
+      boxed.symbol_at(i).superpose(boxed[j], j);
+    }
+  }
+
+  for (unsigned i = 0; i < 8; ++i) {
+    auto f = flat[i].vector();
+    auto b = boxed[i].vector();
+    BOOST_CHECK(std::equal(f.begin(), f.end(), b.begin()));
+    BOOST_CHECK_EQUAL(flat[i].similarity(flat[0]), boxed[i].similarity(boxed[0]));
+    BOOST_CHECK_EQUAL(flat[i].inner(flat[0]), boxed[i].inner(boxed[0]));
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(migrate_symbols) {
+  for (unsigned i = 0; i < 8; ++i) {
+    std::string n = "s" + std::to_string(i);
+    BOOST_REQUIRE(boxed.insert_symbol(n, basis_for(i)));
+  }
+  for (unsigned i = 1; i < 8; ++i) boxed.symbol_at(0).superpose(boxed[i]);
+
+  BOOST_CHECK_EQUAL(sdm::mms::copy_symbols(boxed, flat), 8);
+
+  for (unsigned i = 0; i < 8; ++i) {
+    BOOST_CHECK_EQUAL(flat[i].name(), boxed[i].name());
+    BOOST_CHECK(std::equal(flat[i].basis().begin(), flat[i].basis().end(), boxed[i].basis().begin()));
+    BOOST_CHECK_EQUAL(flat[i].count(), boxed[i].count());
+  }
+  BOOST_CHECK(flat.get_symbol_by_name("s0")->count() > 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(layout_mismatch) {
+  // each image already holds a space of the other layout
+  BOOST_CHECK_THROW(boxed_space_t("misfit", flat_segment), std::runtime_error);
+  BOOST_CHECK_THROW(flat_space_t("misfit", boxed_segment), std::runtime_error);
+
+  // and a name order with ranks
+  typedef sdm::mms::symbol_space<unsigned long, 256, 16, segment_t,
+                                 sdm::mms::symbol, false> unranked_space_t;
+  BOOST_CHECK_THROW(unranked_space_t("misfit", boxed_segment), std::runtime_error);
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,115 @@
+/***************************************************************************
+ * popcount kernel agreement -- every kernel the cpu supports must agree
+ * with the scalar kernel
+ *
+ * See: LICENSE for conditions under which this software is published.
+ ***************************************************************************/
+#include <iostream>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE mms-kernels
+#include <boost/test/included/unit_test.hpp>
+#include "mms/bitvector_kernels.hpp"
+
+using namespace sdm::mms;
+
+// random words with a given chance of a bit being set
+
+std::vector<kernels::word_t> random_words(std::mt19937_64& rng,
+                                          const std::size_t n,
+                                          const unsigned sparsity) {
+  std::vector<kernels::word_t> ws(n);
+  for (auto& w: ws) {
+    w = rng();
+    for (unsigned s = 0; s < sparsity; ++s) w &= rng();
+  }
+  return ws;
+}
+
+
+BOOST_AUTO_TEST_SUITE(mms_kernels)
+
+
+BOOST_AUTO_TEST_CASE(kernels_agree) {
+
+  const kernels::popcount_kernels& reference = kernels::scalar_kernels();
+  std::vector<const kernels::popcount_kernels*> ks = kernels::supported();
+
+  BOOST_TEST_MESSAGE("dispatched kernels: " << kernels::dispatch().name);
+  BOOST_REQUIRE(ks.size() > 0);
+
+  std::mt19937_64 rng(0x5db);
+
+  // vector sizes cover whole harley-seal blocks and all the tails
+  for (std::size_t n: {0, 1, 3, 4, 7, 8, 15, 16, 63, 64, 65, 129, 200, 256, 257}) {
+    for (unsigned sparsity: {0, 3}) {
+
+      auto a = random_words(rng, n, sparsity);
+      auto b = random_words(rng, n, sparsity);
+
+      for (auto k: ks) {
+        BOOST_TEST_MESSAGE(k->name << " n=" << n);
+        BOOST_CHECK_EQUAL(k->count(a.data(), n), reference.count(a.data(), n));
+        BOOST_CHECK_EQUAL(k->distance(a.data(), b.data(), n), reference.distance(a.data(), b.data(), n));
+        BOOST_CHECK_EQUAL(k->inner(a.data(), b.data(), n), reference.inner(a.data(), b.data(), n));
+        BOOST_CHECK_EQUAL(k->countsum(a.data(), b.data(), n), reference.countsum(a.data(), b.data(), n));
+
+        kernels::metrics m = k->measure(a.data(), b.data(), n);
+        BOOST_CHECK_EQUAL(m.count, reference.count(b.data(), n));
+        BOOST_CHECK_EQUAL(m.distance, reference.distance(a.data(), b.data(), n));
+        BOOST_CHECK_EQUAL(m.inner, reference.inner(a.data(), b.data(), n));
+      }
+
+      // bounded distances are exact within the bound and over it otherwise
+      const std::size_t exact = reference.distance(a.data(), b.data(), n);
+      for (std::size_t bound: {std::size_t(0), exact / 3, exact ? exact - 1 : 0, exact, ~std::size_t(0)})
+        for (auto k: ks) {
+          const std::size_t d = k->distance_within(a.data(), b.data(), n, bound);
+          if (exact <= bound) BOOST_CHECK_EQUAL(d, exact);
+          else BOOST_CHECK(d > bound);
+        }
+
+      // many to many tile of rows drawn from both vectors
+      std::vector<kernels::word_t> c = random_words(rng, n, sparsity);
+      const kernels::word_t* as[] = {a.data(), b.data(), c.data(), a.data()};
+      const kernels::word_t* bs[] = {c.data(), a.data(), b.data(), b.data()};
+      for (std::size_t bound: {std::size_t(0), exact / 3, exact, ~std::size_t(0)})
+        for (auto k: ks) {
+          std::size_t out[kernels::tile_rows * kernels::tile_rows];
+          k->distance_tile(as, bs, n, bound, out);
+          for (std::size_t i = 0; i < kernels::tile_rows; ++i)
+            for (std::size_t j = 0; j < kernels::tile_rows; ++j) {
+              const std::size_t e = reference.distance(as[i], bs[j], n);
+              if (e <= bound) BOOST_CHECK_EQUAL(out[i * kernels::tile_rows + j], e);
+              else BOOST_CHECK(out[i * kernels::tile_rows + j] > bound);
+            }
+        }
+    }
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(kernels_saturated) {
+  // all ones stresses the carry save adders
+  std::vector<kernels::word_t> ones(256, ~0ULL);
+  std::vector<kernels::word_t> zeros(256, 0ULL);
+
+  for (auto k: kernels::supported()) {
+    BOOST_CHECK_EQUAL(k->count(ones.data(), 256), 16384);
+    BOOST_CHECK_EQUAL(k->distance(ones.data(), zeros.data(), 256), 16384);
+    BOOST_CHECK_EQUAL(k->inner(ones.data(), zeros.data(), 256), 0);
+    BOOST_CHECK_EQUAL(k->countsum(ones.data(), zeros.data(), 256), 16384);
+
+    kernels::metrics m = k->measure(zeros.data(), ones.data(), 256);
+    BOOST_CHECK_EQUAL(m.count, 16384);
+    BOOST_CHECK_EQUAL(m.distance, 16384);
+    BOOST_CHECK_EQUAL(m.inner, 0);
+
+    BOOST_CHECK_EQUAL(k->distance_within(ones.data(), zeros.data(), 256, 16384), 16384);
+    BOOST_CHECK(k->distance_within(ones.data(), zeros.data(), 256, 100) > 100);
+  }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,6 +2,7 @@
 // copyright (c) 2015 Simon Beaumont. All Rights Reserved.
 
 #include <cstdio>
+#include <set>
 #include <boost/algorithm/string.hpp>
 
 #define BOOST_TEST_MODULE manifold_api
@@ -93,4 +94,616 @@ BOOST_AUTO_TEST_CASE(rtl_api) {
 }
 
 
+BOOST_AUTO_TEST_CASE(topology_top_k) {
+
+  // enough symbols to span several scan chunks with plenty of tied scores
+  for (unsigned i = 0; i < 6000; ++i) {
+    sdm_status_t s = db.superpose("many", "m" + std::to_string(i), "many", "m" + std::to_string(i % 97));
+    BOOST_REQUIRE(!sdm_error(s));
+  }
+
+  // brute force ranking in space order
+  database::geometry g;
+  BOOST_REQUIRE(!sdm_error(db.get_geometry("many", g)));
+
+  std::vector<std::pair<double, std::string>> ranking;
+  for (auto& p: g) {
+    auto s = db.similarity("many", p.name, "many", "m5");
+    BOOST_REQUIRE(!sdm_error(s.first));
+    ranking.push_back(std::make_pair(s.second, p.name));
+  }
+  std::stable_sort(ranking.begin(), ranking.end(),
+                   [](const std::pair<double, std::string>& a, const std::pair<double, std::string>& b) {
+                     return a.first > b.first;
+                   });
+
+  sdm_vector_t v;
+  BOOST_REQUIRE(!sdm_error(db.load_vector("many", "m5", v)));
+
+  for (sdm_size_t k: {1, 7, 150, 10000}) {
+    database::topology t;
+    BOOST_REQUIRE(!sdm_error(db.get_topology("many", v, t, 1.0, 0.0, k)));
+    BOOST_REQUIRE_EQUAL(t.size(), std::min<std::size_t>(k, ranking.size()));
+    for (std::size_t i = 0; i < t.size(); ++i) {
+      BOOST_CHECK_EQUAL(t[i].name, ranking[i].second);
+      BOOST_CHECK_EQUAL(t[i].similarity, ranking[i].first);
+    }
+  }
+
+  // named vector variant agrees
+  database::topology a, b;
+  BOOST_REQUIRE(!sdm_error(db.get_topology("many", "many", "m5", a, 1.0, 0.0, 50)));
+  BOOST_REQUIRE(!sdm_error(db.get_topology("many", v, b, 1.0, 0.0, 50)));
+  BOOST_CHECK(a == b);
+}
+
+
+BOOST_AUTO_TEST_CASE(topology_density_order) {
+
+  for (unsigned i = 0; i < 5000; ++i) {
+    // a spread of densities
+    for (unsigned j = 0; j <= i % 5; ++j) {
+      sdm_status_t s = db.superpose("dense", "d" + std::to_string(i), "dense", "d" + std::to_string((i + j * 31) % 211));
+      BOOST_REQUIRE(!sdm_error(s));
+    }
+  }
+
+  sdm_vector_t v;
+  BOOST_REQUIRE(!sdm_error(db.load_vector("dense", "d17", v)));
+
+  struct bounds { double dub; double mlb; sdm_size_t cub; };
+  std::vector<bounds> queries = {{1.0, 0.0, 10}, {1.0, 0.99, 100}, {0.003, 0.5, 1000},
+                                 {0.5, 0.999, sdm_size_t(-1)}, {1.0, 0.0, sdm_size_t(-1)},
+                                 {0.0, 0.0, 5}};
+
+  // ordered scans must answer exactly as full scans
+  auto scan_all = [&](bool ordered) {
+    std::vector<database::topology> ts;
+    BOOST_REQUIRE(!sdm_error(db.order_by_density("dense", ordered)));
+    for (auto& q: queries) {
+      database::topology t;
+      BOOST_REQUIRE(!sdm_error(db.get_topology("dense", v, t, q.dub, q.mlb, q.cub)));
+      ts.push_back(t);
+    }
+    return ts;
+  };
+
+  auto full = scan_all(false);
+  auto ranged = scan_all(true);
+  for (std::size_t i = 0; i < queries.size(); ++i) {
+    BOOST_CHECK_EQUAL(full[i].size(), ranged[i].size());
+    BOOST_CHECK(full[i] == ranged[i]);
+  }
+  BOOST_CHECK(full[0].size() == 10 && full[4].size() == 5000 && full[5].empty());
+
+  // a little learning patches rather than rebuilds the order
+  for (unsigned i = 0; i < 10; ++i)
+    BOOST_REQUIRE(!sdm_error(db.superpose("dense", "d" + std::to_string(i * 7), "dense", "new" + std::to_string(i))));
+
+  ranged = scan_all(true);
+  full = scan_all(false);
+  for (std::size_t i = 0; i < queries.size(); ++i) {
+    BOOST_CHECK_EQUAL(full[i].size(), ranged[i].size());
+    BOOST_CHECK(full[i] == ranged[i]);
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(topology_mih) {
+
+  // near duplicates among a few hundred symbols
+  for (unsigned i = 0; i < 600; ++i) {
+    for (unsigned j = 0; j < 3; ++j) {
+      sdm_status_t s = db.superpose("hashed", "h" + std::to_string(i), "hashed", "h" + std::to_string((i / 3 + j) % 600));
+      BOOST_REQUIRE(!sdm_error(s));
+    }
+  }
+
+  sdm_vector_t v;
+  BOOST_REQUIRE(!sdm_error(db.load_vector("hashed", "h42", v)));
+
+  std::vector<std::pair<double, sdm_size_t>> queries = {{0.9999, 10}, {0.9998, 100}, {0.9997, sdm_size_t(-1)},
+                                                        {0.999, 10}, {0.998, sdm_size_t(-1)},
+                                                        {0.9, 100}, {0.0, 20}};
+  std::vector<database::topology> full;
+  for (auto& q: queries) {
+    database::topology t;
+    BOOST_REQUIRE(!sdm_error(db.get_topology("hashed", v, t, 1.0, q.first, q.second)));
+    full.push_back(t);
+  }
+
+  BOOST_CHECK_EQUAL(db.build_mih("hashed", 5), EINDEX);
+  BOOST_CHECK_EQUAL(db.build_mih("nowhere"), ESPACE);
+  BOOST_REQUIRE(!sdm_error(db.build_mih("hashed", 4)));
+
+  for (std::size_t i = 0; i < queries.size(); ++i) {
+    database::topology t;
+    BOOST_REQUIRE(!sdm_error(db.get_topology("hashed", v, t, 1.0, queries[i].first, queries[i].second)));
+    BOOST_CHECK(t == full[i]);
+  }
+  BOOST_CHECK(full[0].size() >= 3);
+}
+
+
+BOOST_AUTO_TEST_CASE(topology_sketched) {
+
+  for (unsigned i = 0; i < 3000; ++i) {
+    sdm_status_t s = db.superpose("sketched", "k" + std::to_string(i), "sketched", "k" + std::to_string(i % 53));
+    BOOST_REQUIRE(!sdm_error(s));
+  }
+
+  sdm_vector_t v;
+  BOOST_REQUIRE(!sdm_error(db.load_vector("sketched", "k7", v)));
+
+  // a shortlist of the whole space is exact and the default one finds
+  // the query itself
+  for (auto bounds: {std::make_pair(0.0, sdm_size_t(10)), std::make_pair(0.9, sdm_size_t(-1))}) {
+    database::topology exact, whole;
+    BOOST_REQUIRE(!sdm_error(db.get_topology("sketched", v, exact, 1.0, bounds.first, bounds.second)));
+    BOOST_REQUIRE(!sdm_error(db.get_topology_sketched("sketched", v, whole, 1.0, bounds.first, bounds.second, 3000)));
+    BOOST_CHECK(!exact.empty());
+    BOOST_CHECK(whole == exact);
+  }
+
+  database::topology t;
+  BOOST_REQUIRE(!sdm_error(db.get_topology_sketched("sketched", v, t, 1.0, 0.0, 10)));
+  BOOST_REQUIRE_EQUAL(t.size(), 10);
+  BOOST_CHECK_EQUAL(t[0].similarity, 1.0);
+
+  // learning reaches the sketches before the next query
+  sdm_vector_t w;
+  BOOST_REQUIRE(!sdm_error(db.load_vector("sketched", "k2999", w)));
+  for (unsigned j = 0; j < 20; ++j)
+    BOOST_REQUIRE(!sdm_error(db.superpose("sketched", "k2999", "sketched", "k" + std::to_string(100 + j))));
+  BOOST_REQUIRE(!sdm_error(db.load_vector("sketched", "k2999", w)));
+  t.clear();
+  BOOST_REQUIRE(!sdm_error(db.get_topology_sketched("sketched", w, t, 1.0, 0.0, 1)));
+  BOOST_REQUIRE_EQUAL(t.size(), 1);
+  BOOST_CHECK_EQUAL(t[0].name, "k2999");
+
+  BOOST_CHECK_EQUAL(db.get_topology_sketched("nowhere", v, t), ESPACE);
+}
+
+
+BOOST_AUTO_TEST_CASE(topology_metrics) {
+
+  for (unsigned i = 0; i < 2000; ++i) {
+    const std::string name = "m" + std::to_string(i);
+    for (unsigned j = 0; j <= i % 7; ++j)
+      BOOST_REQUIRE(!sdm_error(db.superpose("metrics", name, "metrics", "m" + std::to_string((i + j * 31) % 397))));
+  }
+
+  database::geometry g;
+  BOOST_REQUIRE(!sdm_error(db.get_geometry("metrics", g)));
+  std::vector<sdm_vector_t> vs(g.size());
+  for (std::size_t i = 0; i < g.size(); ++i) BOOST_REQUIRE(!sdm_error(db.load_vector("metrics", g[i].name, vs[i])));
+
+  auto popcount = [](const SDM_VECTOR_ELEMENT_TYPE* a, const SDM_VECTOR_ELEMENT_TYPE* b, int op) {
+    std::size_t c = 0;
+    for (std::size_t w = 0; w < SDM_VECTOR_ELEMS; ++w)
+      c += __builtin_popcountll(op == 0 ? a[w] : op == 1 ? a[w] ^ b[w] : a[w] | b[w]);
+    return c;
+  };
+
+  const double dims = SDM_VECTOR_ELEMS * 64;
+  const std::size_t q = 11;
+  const std::size_t tc = popcount(vs[q], vs[q], 0);
+
+  struct query { sdm_metric_t metric; double dlb, dub, mlb, mub; sdm_size_t cub; };
+  std::vector<query> queries = {{similarity, 0.0, 1.0, 0.0, 1.0, 15}, {similarity, 0.0, 0.01, 0.95, 1.0, 40},
+                                {overlap, 0.0, 1.0, 0.0, 1.0, 15}, {overlap, 0.002, 1.0, 0.0005, 0.004, 40},
+                                {jaccard, 0.0, 1.0, 0.0, 1.0, 15}, {jaccard, 0.0, 1.0, 0.1, 0.9, 40},
+                                {hamming, 0.0, 1.0, 0.0, dims, 15}, {hamming, 0.0, 1.0, 10, 400, 40}};
+
+  for (bool ordered: {false, true}) {
+    BOOST_REQUIRE(!sdm_error(db.order_by_density("metrics", ordered)));
+
+    for (auto& x: queries) {
+      // every symbol measured by brute force
+      std::vector<double> expected;
+      for (std::size_t i = 0; i < g.size(); ++i) {
+        const std::size_t vc = popcount(vs[i], vs[i], 0), d = popcount(vs[q], vs[i], 1);
+        const double u = popcount(vs[q], vs[i], 2);
+        const double v = x.metric == similarity ? 1.0 - d / dims
+          : x.metric == overlap ? (tc + vc - d) / 2 / dims
+          : x.metric == jaccard ? (u ? (u - d) / u : 1.0)
+          : double(d);
+        if (vc / dims >= x.dlb && vc / dims <= x.dub && v >= x.mlb && v <= x.mub) expected.push_back(v);
+      }
+      if (x.metric == hamming) std::sort(expected.begin(), expected.end());
+      else std::sort(expected.rbegin(), expected.rend());
+      if (expected.size() > x.cub) expected.resize(x.cub);
+      BOOST_CHECK(!expected.empty());
+
+      database::topology by_vector, by_name;
+      BOOST_REQUIRE(!sdm_error(db.get_topology("metrics", vs[q], x.cub, x.metric, x.dlb, x.dub, x.mlb, x.mub, by_vector)));
+      BOOST_REQUIRE(!sdm_error(db.get_topology("metrics", "metrics", g[q].name, x.cub, x.metric,
+                                               x.dlb, x.dub, x.mlb, x.mub, by_name)));
+      BOOST_REQUIRE_EQUAL(by_vector.size(), expected.size());
+      BOOST_CHECK(by_name == by_vector);
+      for (std::size_t i = 0; i < expected.size(); ++i) {
+        BOOST_CHECK_CLOSE(by_vector[i].metric + 1, expected[i] + 1, 1e-9);
+        BOOST_CHECK_EQUAL(by_vector[i].ranked_by, x.metric);
+        if (i > 0) BOOST_CHECK(!(by_vector[i] < by_vector[i - 1]));
+      }
+
+      // the c topology names the same symbols and ends short ones
+      std::vector<sdm_neighbour_t> top(x.cub);
+      BOOST_REQUIRE(!sdm_error(db.get_topology("metrics", vs[q], x.cub, x.metric,
+                                               x.dlb, x.dub, x.mlb, x.mub, top.data())));
+      for (std::size_t i = 0; i < by_vector.size(); ++i) {
+        BOOST_CHECK_EQUAL(top[i].p.name, by_vector[i].name);
+        BOOST_CHECK_EQUAL(top[i].metric, by_vector[i].metric);
+      }
+      if (by_vector.size() < x.cub) BOOST_CHECK(top[by_vector.size()].p.name == nullptr);
+    }
+  }
+
+  // similarity is the default ranking
+  database::topology plain, ranked;
+  BOOST_REQUIRE(!sdm_error(db.get_topology("metrics", vs[q], plain, 1.0, 0.5, 25)));
+  BOOST_REQUIRE(!sdm_error(db.get_topology("metrics", vs[q], 25, similarity, 0.0, 1.0, 0.5, 1.0, ranked)));
+  BOOST_CHECK(plain == ranked);
+
+  BOOST_CHECK_EQUAL(db.get_topology("nowhere", vs[q], 10, overlap, 0.0, 1.0, 0.0, 1.0, ranked), ESPACE);
+  BOOST_CHECK_EQUAL(db.get_topology("metrics", "metrics", "missing", 10, overlap, 0.0, 1.0, 0.0, 1.0, ranked), ESYMBOL);
+}
+
+
+BOOST_AUTO_TEST_CASE(count_topology) {
+
+  for (unsigned i = 0; i < 3000; ++i) {
+    const std::string name = "c" + std::to_string(i);
+    for (unsigned j = 0; j <= i % 5; ++j)
+      BOOST_REQUIRE(!sdm_error(db.superpose("counted", name, "counted", "c" + std::to_string((i + j * 17) % 211))));
+  }
+
+  sdm_vector_t v;
+  BOOST_REQUIRE(!sdm_error(db.load_vector("counted", "c5", v)));
+
+  struct band { sdm_metric_t metric; double dlb, dub, mlb, mub; };
+  std::vector<band> bands = {{similarity, 0.0, 1.0, 0.0, 1.0}, {similarity, 0.001, 0.004, 0.992, 0.999},
+                             {jaccard, 0.0, 1.0, 0.05, 1.0}, {hamming, 0.0, 1.0, 20, 90}};
+
+  for (bool ordered: {false, true}) {
+    BOOST_REQUIRE(!sdm_error(db.order_by_density("counted", ordered)));
+
+    for (auto& b: bands) {
+      // the level set in full by get_topology
+      database::topology t;
+      BOOST_REQUIRE(!sdm_error(db.get_topology("counted", v, -1, b.metric, b.dlb, b.dub, b.mlb, b.mub, t)));
+
+      std::size_t count = 1;
+      std::vector<std::size_t> none;
+      BOOST_REQUIRE(!sdm_error(db.count_topology("counted", v, b.metric, b.dlb, b.dub, b.mlb, b.mub, count, none)));
+      BOOST_CHECK_EQUAL(count, t.size());
+      BOOST_CHECK(count > 0);
+
+      const std::size_t buckets = 8;
+      const double lo = b.mlb, width = (std::min(b.mub, b.metric == hamming ? 16384.0 : 1.0) - lo) / buckets;
+      std::vector<std::size_t> expected(buckets), histogram(buckets, 7);
+      for (auto& nb: t) ++expected[std::min(std::size_t((nb.metric - lo) / width), buckets - 1)];
+
+      BOOST_REQUIRE(!sdm_error(db.count_topology("counted", "counted", "c5", b.metric,
+                                                 b.dlb, b.dub, b.mlb, b.mub, count, histogram)));
+      BOOST_CHECK_EQUAL(count, t.size());
+      BOOST_CHECK(histogram == expected);
+    }
+  }
+
+  std::size_t count;
+  std::vector<std::size_t> none;
+  BOOST_CHECK_EQUAL(db.count_topology("nowhere", v, similarity, 0.0, 1.0, 0.5, 1.0, count, none), ESPACE);
+  BOOST_CHECK_EQUAL(db.count_topology("counted", "counted", "missing", similarity, 0.0, 1.0, 0.5, 1.0, count, none), ESYMBOL);
+}
+
+
+BOOST_AUTO_TEST_CASE(topology_prefix) {
+
+  const std::vector<std::string> namespaces = {"ns/", "ns2/", "other/"};
+  for (unsigned i = 0; i < 1500; ++i) {
+    const std::string name = namespaces[i % 3] + std::to_string(i);
+    BOOST_REQUIRE(!sdm_error(db.superpose("prefixed", name, "prefixed", "other/" + std::to_string(i % 61 * 3 + 2))));
+  }
+
+  sdm_vector_t v;
+  BOOST_REQUIRE(!sdm_error(db.load_vector("prefixed", "ns/300", v)));
+
+  for (auto bounds: {std::make_pair(0.0, sdm_size_t(10)), std::make_pair(0.999, sdm_size_t(-1))}) {
+    // the whole space filtered by name afterwards
+    database::topology all;
+    BOOST_REQUIRE(!sdm_error(db.get_topology("prefixed", v, all, 1.0, bounds.first, -1)));
+
+    for (const std::string prefix: {"ns/", "ns", "other/1", ""}) {
+      database::topology expected;
+      for (auto& n: all)
+        if (n.name.compare(0, prefix.size(), prefix) == 0 && expected.size() < bounds.second) expected.push_back(n);
+
+      database::topology by_vector, by_name;
+      BOOST_REQUIRE(!sdm_error(db.get_topology("prefixed", v, prefix, by_vector, 1.0, bounds.first, bounds.second)));
+      BOOST_REQUIRE(!sdm_error(db.get_topology("prefixed", "prefixed", "ns/300", prefix, by_name,
+                                               1.0, bounds.first, bounds.second)));
+      BOOST_CHECK(!by_vector.empty());
+      BOOST_CHECK(by_vector == expected);
+      BOOST_CHECK(by_name == expected);
+    }
+  }
+
+  database::topology t;
+  BOOST_REQUIRE(!sdm_error(db.get_topology("prefixed", v, "none/", t, 1.0, 0.0, 10)));
+  BOOST_CHECK(t.empty());
+  BOOST_CHECK_EQUAL(db.get_topology("nowhere", v, "ns/", t), ESPACE);
+  BOOST_CHECK_EQUAL(db.get_topology("prefixed", "prefixed", "missing", "ns/", t), ESYMBOL);
+}
+
+
+BOOST_AUTO_TEST_CASE(prefix_pages) {
+
+  for (unsigned i = 0; i < 700; ++i)
+    BOOST_REQUIRE(!sdm_error(db.namedvector("paged", (i % 7 ? "ns/" : "other/") + std::to_string(i))));
+
+  auto count = db.prefix_count("paged", "ns/");
+  BOOST_REQUIRE(!sdm_error(count.first));
+  BOOST_CHECK_EQUAL(count.second, 600);
+  BOOST_CHECK_EQUAL(db.prefix_count("paged", "").second, 700);
+  BOOST_CHECK_EQUAL(db.prefix_count("nowhere", "ns/").first, ESPACE);
+
+  // pages in name order picking up where the last left off
+  auto all = db.prefix_search("paged", "ns/");
+  auto expected = all.second.first;
+  std::size_t cursor = 0, seen = 0;
+  sdm_point_t page[64];
+  for (;;) {
+    BOOST_REQUIRE(!sdm_error(db.prefix_page("paged", "ns/", cursor, 64, page)));
+    std::size_t n = 0;
+    while (n < 64 && page[n].name) {
+      BOOST_CHECK_EQUAL(page[n].name, expected->name());
+      ++expected; ++n;
+    }
+    seen += n;
+    if (n < 64) break;
+  }
+  BOOST_CHECK_EQUAL(seen, 600);
+  BOOST_CHECK_EQUAL(cursor, 600);
+  BOOST_CHECK(expected == all.second.second);
+
+  auto past = db.prefix_page("paged", "ns/", cursor, 64);
+  BOOST_CHECK(past.second.first == past.second.second);
+}
+
+
+BOOST_AUTO_TEST_CASE(symbol_handles) {
+
+  for (unsigned i = 0; i < 200; ++i)
+    BOOST_REQUIRE(!sdm_error(db.superpose("handled", "h" + std::to_string(i), "handled", "h" + std::to_string(i % 13))));
+
+  auto a = db.resolve("handled", "h3");
+  auto b = db.resolve("handled", "h16");
+  BOOST_REQUIRE(!sdm_error(a.first) && !sdm_error(b.first));
+  BOOST_CHECK(a.second.symbol != b.second.symbol);
+  BOOST_CHECK_EQUAL(a.second.space, b.second.space);
+
+  // handles answer as names do
+  BOOST_CHECK_EQUAL(db.density(a.second).second, db.density("handled", "h3").second);
+  BOOST_CHECK_EQUAL(db.similarity(a.second, b.second).second, db.similarity("handled", "h3", "handled", "h16").second);
+  BOOST_CHECK_EQUAL(db.overlap(a.second, b.second).second, db.overlap("handled", "h3", "handled", "h16").second);
+
+  sdm_vector_t u, v;
+  BOOST_REQUIRE(!sdm_error(db.load_vector(a.second, u)));
+  BOOST_REQUIRE(!sdm_error(db.load_vector("handled", "h3", v)));
+  BOOST_CHECK(std::equal(u, u + SDM_VECTOR_ELEMS, v));
+
+  auto space = db.resolve_space("handled");
+  BOOST_REQUIRE(!sdm_error(space.first));
+  database::topology by_handle, by_name;
+  BOOST_REQUIRE(!sdm_error(db.get_topology(space.second, a.second, by_handle, 1.0, 0.0, 20)));
+  BOOST_REQUIRE(!sdm_error(db.get_topology("handled", "handled", "h3", by_name, 1.0, 0.0, 20)));
+  BOOST_CHECK(by_handle == by_name);
+
+  // learning by handle and new symbols and spaces leave handles good
+  auto c = db.ensure_handle("handled", "fresh");
+  BOOST_CHECK_EQUAL(c.first, ANEW);
+  BOOST_REQUIRE(!sdm_error(db.superpose(c.second, b.second)));
+  for (unsigned i = 0; i < 500; ++i)
+    BOOST_REQUIRE(!sdm_error(db.namedvector(i % 2 ? "handled" : "elsewhere", "more" + std::to_string(i))));
+
+  BOOST_CHECK_EQUAL(db.ensure_handle("handled", "fresh").first, AOLD);
+  BOOST_CHECK_EQUAL(db.similarity(c.second, b.second).second, db.similarity("handled", "fresh", "handled", "h16").second);
+  BOOST_CHECK(db.density(c.second).second > 0);
+  BOOST_CHECK_EQUAL(db.density(a.second).second, db.density("handled", "h3").second);
+
+  // and bad handles are refused
+  sdm_handle_t nowhere = {1000, 0}, nothing = {a.second.space, 100000};
+  BOOST_CHECK_EQUAL(db.density(nowhere).first, ESPACE);
+  BOOST_CHECK_EQUAL(db.density(nothing).first, ESYMBOL);
+  BOOST_CHECK_EQUAL(db.superpose(a.second, nothing), ESYMBOL);
+  BOOST_CHECK_EQUAL(db.get_topology(1000, a.second, by_handle), ESPACE);
+  BOOST_CHECK_EQUAL(db.resolve("handled", "missing").first, ESYMBOL);
+  BOOST_CHECK_EQUAL(db.resolve("nowhere", "h3").first, ESPACE);
+}
+
+
+BOOST_AUTO_TEST_CASE(superpose_batch) {
+
+  std::vector<std::string> frame;
+  for (unsigned i = 0; i < 40; ++i) {
+    frame.push_back("t" + std::to_string(i * 7 % 23));
+    if (i < 20) BOOST_REQUIRE(!sdm_error(db.namedvector("terms", frame.back())));
+  }
+
+  // one call for the frame answers as a call per term
+  BOOST_CHECK_EQUAL(db.superpose("frames", "batched", "terms", frame), ANEW);
+  for (auto& term: frame) BOOST_REQUIRE(!sdm_error(db.superpose("frames", "single", "terms", term)));
+
+  sdm_vector_t u, v;
+  BOOST_REQUIRE(!sdm_error(db.load_vector("frames", "batched", u)));
+  BOOST_REQUIRE(!sdm_error(db.load_vector("frames", "single", v)));
+  BOOST_CHECK(std::equal(u, u + SDM_VECTOR_ELEMS, v));
+  BOOST_CHECK(db.density("frames", "batched").second > 0);
+  BOOST_CHECK_EQUAL(db.get_space_cardinality("terms").second, 23);
+  BOOST_CHECK_EQUAL(db.superpose("frames", "batched", "terms", frame), AOLD);
+
+  // and by handles
+  std::vector<sdm_handle_t> terms;
+  for (auto& term: frame) terms.push_back(db.resolve("terms", term).second);
+  auto h = db.ensure_handle("frames", "handled");
+  BOOST_REQUIRE(!sdm_error(db.superpose(h.second, terms)));
+  BOOST_REQUIRE(!sdm_error(db.load_vector(h.second, v)));
+  BOOST_CHECK(std::equal(u, u + SDM_VECTOR_ELEMS, v));
+
+  BOOST_CHECK_EQUAL(db.superpose("frames", "batched", "terms", frame, std::vector<int>(3)), ERUNTIME);
+  terms.push_back(sdm_handle_t{h.second.space, 100000});
+  BOOST_CHECK_EQUAL(db.superpose(h.second, terms), ESYMBOL);
+}
+
+
+BOOST_AUTO_TEST_CASE(bundle_frame) {
+
+  // a frame with repeated terms bundled
+  std::vector<std::string> frame;
+  std::vector<sdm_handle_t> terms;
+  for (unsigned i = 0; i < 30; ++i) {
+    frame.push_back("t" + std::to_string(i * 7 % 23));
+    terms.push_back(db.ensure_handle("bundled", frame.back()).second);
+  }
+  BOOST_REQUIRE(!sdm_error(db.bundle(terms)));
+
+  // and the learning of symmetric pairwise co-training replayed
+  // elsewhere: each term takes every other of the frame
+  for (std::size_t i = 0; i < terms.size(); ++i)
+    for (std::size_t j = 0; j < terms.size(); ++j) if (i != j) {
+        auto e = db.ensure_handle("expected", frame[i]);
+        BOOST_REQUIRE(!sdm_error(e.first));
+        BOOST_REQUIRE(!sdm_error(db.superpose(e.second, terms[j])));
+      }
+
+  sdm_vector_t u, v;
+  for (unsigned i = 0; i < 23; ++i) {
+    const std::string term = "t" + std::to_string(i);
+    BOOST_REQUIRE(!sdm_error(db.load_vector("expected", term, u)));
+    BOOST_REQUIRE(!sdm_error(db.load_vector("bundled", term, v)));
+    BOOST_CHECK(std::equal(u, u + SDM_VECTOR_ELEMS, v));
+  }
+  BOOST_CHECK(db.density("bundled", "t0").second > 0);
+
+  BOOST_CHECK_EQUAL(db.bundle(std::vector<sdm_handle_t>()), AOLD);
+  terms.push_back(db.resolve("expected", "t0").second);
+  BOOST_CHECK_EQUAL(db.bundle(terms), ESPACE);
+  terms.back() = sdm_handle_t{terms.front().space, 100000};
+  BOOST_CHECK_EQUAL(db.bundle(terms), ESYMBOL);
+}
+
+
+BOOST_AUTO_TEST_CASE(topology_batch) {
+
+  for (unsigned i = 0; i < 5000; ++i) {
+    sdm_status_t s = db.superpose("batched", "b" + std::to_string(i), "batched", "b" + std::to_string(i % 89));
+    BOOST_REQUIRE(!sdm_error(s));
+  }
+
+  // enough queries for several target tiles
+  std::vector<std::string> names;
+  for (unsigned i = 0; i < 40; ++i) names.push_back("b" + std::to_string(i * 97 % 5000));
+  std::vector<sdm_vector_t> vectors(names.size());
+  for (std::size_t q = 0; q < names.size(); ++q)
+    BOOST_REQUIRE(!sdm_error(db.load_vector("batched", names[q], vectors[q])));
+
+  for (auto bounds: {std::make_pair(0.0, sdm_size_t(10)), std::make_pair(0.9, sdm_size_t(-1))}) {
+    std::vector<database::topology> named, given;
+    BOOST_REQUIRE(!sdm_error(db.get_topology_batch("batched", "batched", names, named, 1.0, bounds.first, bounds.second)));
+    BOOST_REQUIRE(!sdm_error(db.get_topology_batch("batched", vectors.data(), vectors.size(), given,
+                                                   1.0, bounds.first, bounds.second)));
+    BOOST_REQUIRE_EQUAL(named.size(), names.size());
+    BOOST_REQUIRE_EQUAL(given.size(), names.size());
+
+    for (std::size_t q = 0; q < names.size(); ++q) {
+      database::topology t;
+      BOOST_REQUIRE(!sdm_error(db.get_topology("batched", "batched", names[q], t, 1.0, bounds.first, bounds.second)));
+      BOOST_CHECK(!t.empty());
+      BOOST_CHECK(named[q] == t);
+      BOOST_CHECK(given[q] == t);
+    }
+  }
+
+  std::vector<database::topology> none;
+  BOOST_CHECK_EQUAL(db.get_topology_batch("batched", "batched", {"b1", "missing"}, none), ESYMBOL);
+  BOOST_CHECK_EQUAL(db.get_topology_batch("nowhere", "batched", names, none), ESPACE);
+}
+
+
+BOOST_AUTO_TEST_CASE(similarity_join) {
+
+  // a ragged number of blocks of clustered symbols
+  for (unsigned i = 0; i < 301; ++i) {
+    sdm_status_t s = db.superpose("joined", "j" + std::to_string(i), "joined", "j" + std::to_string(i % 13));
+    BOOST_REQUIRE(!sdm_error(s));
+  }
+
+  database::geometry g;
+  BOOST_REQUIRE(!sdm_error(db.get_geometry("joined", g)));
+  std::vector<double> densities;
+  for (auto& p: g) densities.push_back(p.density);
+  std::nth_element(densities.begin(), densities.begin() + densities.size() / 2, densities.end());
+
+  for (auto bounds: {std::make_pair(1.0, 0.0), std::make_pair(1.0, 0.7), std::make_pair(densities[densities.size() / 2], 0.6)}) {
+    std::vector<std::vector<database::join_entry>> buffers;
+    BOOST_REQUIRE(!sdm_error(db.similarity_join("joined", buffers, bounds.first, bounds.second)));
+
+    std::vector<std::set<std::pair<std::string, double>>> joined(g.size());
+    for (auto& buffer: buffers)
+      for (auto& e: buffer) BOOST_CHECK(joined[e.i].insert(std::make_pair(g[e.j].name, e.similarity)).second);
+
+    // the same pairs as every topology
+    for (std::size_t i = 0; i < g.size(); ++i) {
+      database::topology t;
+      BOOST_REQUIRE(!sdm_error(db.get_topology("joined", "joined", g[i].name, t, bounds.first, bounds.second)));
+      std::set<std::pair<std::string, double>> expected;
+      for (auto& n: t) expected.insert(std::make_pair(n.name, n.similarity));
+      BOOST_CHECK(joined[i] == expected);
+    }
+  }
+
+  std::vector<std::vector<database::join_entry>> none;
+  BOOST_CHECK_EQUAL(db.similarity_join("nowhere", none), ESPACE);
+}
+
+
+BOOST_AUTO_TEST_CASE(basis_overlap) {
+
+  // a few sources absorbed by many targets
+  for (unsigned i = 0; i < 400; ++i) {
+    for (unsigned j = 0; j < 2; ++j) {
+      sdm_status_t s = db.superpose("absorbing", "a" + std::to_string(i), "sources", "s" + std::to_string((i + j) % 20));
+      BOOST_REQUIRE(!sdm_error(s));
+    }
+  }
+
+  std::vector<database::topology> scanned;
+  for (double mlb: {1.0, 0.5, 0.0}) {
+    database::topology t;
+    BOOST_REQUIRE(!sdm_error(db.get_basis_overlap("absorbing", "sources", "s7", t, mlb, 1000)));
+    for (std::size_t i = 0; i < t.size(); ++i) {
+      BOOST_CHECK(t[i].similarity >= mlb);
+      if (i > 0) BOOST_CHECK(t[i - 1].similarity >= t[i].similarity);
+    }
+    scanned.push_back(t);
+  }
+  // the 40 targets trained on s7 hold all of its bits
+  BOOST_CHECK(scanned[0].size() >= 40);
+
+  BOOST_CHECK_EQUAL(db.build_postings("nowhere"), ESPACE);
+  BOOST_REQUIRE(!sdm_error(db.build_postings("absorbing")));
+
+  std::size_t i = 0;
+  for (double mlb: {1.0, 0.5, 0.0}) {
+    database::topology t;
+    BOOST_REQUIRE(!sdm_error(db.get_basis_overlap("absorbing", "sources", "s7", t, mlb, 1000)));
+    BOOST_CHECK(t == scanned[i++]);
+  }
+
+  database::topology t;
+  BOOST_CHECK_EQUAL(db.get_basis_overlap("absorbing", "sources", "nothing", t), ESYMBOL);
+}
+
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -2,6 +2,7 @@
 // copyright (c) 2015 Simon Beaumont. All Rights Reserved.
 
 #include <cstdio>
+#include <chrono>
 #include <boost/algorithm/string.hpp>
 
 #define BOOST_TEST_MODULE load_symbols
@@ -75,6 +76,34 @@ BOOST_AUTO_TEST_CASE(rts_load_vectors) {
 }
 
 
+BOOST_AUTO_TEST_CASE(rts_lookup_rate) {
+  std::ifstream ins(test_lexicon);
+  BOOST_REQUIRE(ins.good());
+
+  std::vector<std::string> names;
+  std::string fline;
+  while(std::getline(ins, fline) && names.size() < 10000) {
+    boost::trim(fline);
+    if (!sdm_error(rts.namedvector(test_space1, fline))) names.push_back(fline);
+  }
+
+  // every name of the lexicon looked up several times over
+  const int rounds = 20;
+  std::size_t found = 0;
+  sdm_vector_t v;
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; ++r)
+    for (auto& name: names) if (!sdm_error(rts.load_vector(test_space1, name, v))) ++found;
+  const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  BOOST_CHECK_EQUAL(found, rounds * names.size());
+  BOOST_TEST_MESSAGE("lookups: " << found << " at " << found / secs << "/s");
+
+  // absent names are not found
+  BOOST_CHECK(sdm_error(rts.load_vector(test_space1, "no such name in the lexicon", v)));
+}
+
+
 BOOST_AUTO_TEST_CASE(rts_search_empty_space) {
 
   auto card = rts.get_space_cardinality(test_space1);
@@ -374,8 +374,9 @@ int main(int argc, const char** argv) {
       if (parse_symbol(cv[0], default_space, sym)) {
           timer t;
           auto ip = rts.prefix_search(sym.front(), sym.back());
+          auto n = rts.prefix_count(sym.front(), sym.back());
           
-          std::cout << t << std::endl;
+          std::cout << t << " #" << n.second << std::endl;
           if (!sdm_error(ip.first))
             std::copy(ip.second.first, ip.second.second,
                       std::ostream_iterator<database::space::symbol_t>(std::cout, "\n"));
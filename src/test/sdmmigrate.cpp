@@ -0,0 +1,176 @@
+/***************************************************************************
+ * sdmmigrate - convert an image between boxed and flat symbol layouts
+ *              (and images written before names were ranked to either)
+ *
+ * See: LICENSE for conditions under which this software is published.
+ ***************************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <boost/program_options.hpp>
+#include <boost/interprocess/managed_mapped_file.hpp>
+
+#include "../mms/symbol_space.hpp"
+
+#define B2MB(b_) ((double)(b_)/(1024*1024))
+
+namespace bip = boost::interprocess;
+using namespace sdm;
+
+// the two symbol layouts
+
+typedef bip::managed_mapped_file segment_t;
+
+typedef mms::symbol_space<SDM_VECTOR_ELEMENT_TYPE,
+                          SDM_VECTOR_ELEMS,
+                          SDM_VECTOR_BASIS_SIZE,
+                          segment_t> boxed_space_t;
+
+typedef mms::symbol_space<SDM_VECTOR_ELEMENT_TYPE,
+                          SDM_VECTOR_ELEMS,
+                          SDM_VECTOR_BASIS_SIZE,
+                          segment_t,
+                          mms::flat_symbol> flat_space_t;
+
+// and as written before names were ranked
+
+typedef mms::symbol_space<SDM_VECTOR_ELEMENT_TYPE,
+                          SDM_VECTOR_ELEMS,
+                          SDM_VECTOR_BASIS_SIZE,
+                          segment_t,
+                          mms::symbol, false> unranked_boxed_space_t;
+
+typedef mms::symbol_space<SDM_VECTOR_ELEMENT_TYPE,
+                          SDM_VECTOR_ELEMS,
+                          SDM_VECTOR_BASIS_SIZE,
+                          segment_t,
+                          mms::flat_symbol, false> unranked_flat_space_t;
+
+
+// user spaces in a segment
+
+std::vector<std::string> named_spaces(segment_t& segment) {
+  std::vector<std::string> names;
+  for (auto it = segment.named_begin(); it != segment.named_end(); ++it) {
+    if (it->name()[0] != '_') names.push_back(std::string(it->name(), it->name_length()));
+  }
+  return names;
+}
+
+
+// layout tag of an image -- images predating it hold boxed symbols
+
+unsigned image_layout(const std::string& path) {
+  segment_t image(bip::open_copy_on_write, path.c_str());
+  auto found = image.find<unsigned>("_layout");
+  return found.first ? *found.first : SDM_LAYOUT_BOXED;
+}
+
+
+// copy every space of source image into a new target image
+
+template <typename source_space_t, typename target_space_t>
+int migrate(const std::string& from, const std::string& to, std::size_t size) {
+
+  // copy on write so that lookups (which lock) never touch the source file
+  segment_t source(bip::open_copy_on_write, from.c_str());
+  if (size == 0) size = source.get_size();
+
+  segment_t target(bip::create_only, to.c_str(), size);
+
+  for (auto sn: named_spaces(source)) {
+    source_space_t ss(sn, source);
+    target_space_t ts(sn, target);
+    std::size_t n = mms::copy_symbols(ss, ts);
+    std::cout << sn << " #" << n << std::endl;
+    if (n != ss.entries()) {
+      std::cerr << "only copied " << n << " of " << ss.entries() << " symbols" << std::endl;
+      return 9;
+    }
+  }
+
+  std::cout << to << ": " << (target.check_sanity() ? "✔" : "✘")
+            << " heap size: " << B2MB(target.get_size())
+            << " free: " << B2MB(target.get_free_memory()) << std::endl;
+  return 0;
+}
+
+
+// copy from whichever layout the source image was written with
+
+template <typename target_space_t>
+int migrate_to(const std::string& from, const std::string& to, std::size_t size) {
+  const unsigned layout = image_layout(from);
+  switch (layout) {
+  case SDM_LAYOUT_BOXED:
+    return migrate<unranked_boxed_space_t, target_space_t>(from, to, size);
+  case SDM_LAYOUT_FLAT:
+    return migrate<unranked_flat_space_t, target_space_t>(from, to, size);
+  case SDM_LAYOUT_BOXED | SDM_LAYOUT_RANKED:
+    return migrate<boxed_space_t, target_space_t>(from, to, size);
+  case SDM_LAYOUT_FLAT | SDM_LAYOUT_RANKED:
+    return migrate<flat_space_t, target_space_t>(from, to, size);
+  }
+  std::cout << "unknown source layout: " << layout << std::endl;
+  return 7;
+}
+
+
+////////////////////////////////
+// entry point and command line
+
+int main(const int argc, const char** argv) {
+
+  namespace po = boost::program_options;
+
+  std::size_t size;
+  std::string layout;
+
+  po::options_description desc("Allowed options");
+  po::positional_options_description p;
+  p.add("images", 2);
+
+  desc.add_options()
+    ("help", "SDM image layout migration -- sdmmigrate --to flat|boxed source target")
+    ("to", po::value<std::string>(&layout)->default_value("flat"),
+     "layout of target image: flat or boxed")
+    ("size", po::value<std::size_t>(&size)->default_value(0),
+     "size of target heap in Mbytes (default same as source)")
+    ("images", po::value<std::vector<std::string>>(),
+     "source and target image paths");
+
+  po::variables_map opts;
+  po::store(po::command_line_parser(argc, argv).options(desc).positional(p).run(), opts);
+  po::notify(opts);
+
+  if (opts.count("help")) {
+    std::cout << desc << std::endl;
+    return 1;
+  }
+
+  if (!opts.count("images") || opts["images"].as<std::vector<std::string>>().size() != 2) {
+    std::cout << "source and target images are required!" << std::endl;
+    return 3;
+  }
+
+  auto images = opts["images"].as<std::vector<std::string>>();
+
+  if (std::ifstream(images[1]).good()) {
+    std::cout << "will not overwrite existing image: " << images[1] << std::endl;
+    return 5;
+  }
+
+  try {
+    if (layout == "flat")
+      return migrate_to<flat_space_t>(images[0], images[1], size * 1024 * 1024);
+    else if (layout == "boxed")
+      return migrate_to<boxed_space_t>(images[0], images[1], size * 1024 * 1024);
+
+    std::cout << "unknown layout: " << layout << std::endl;
+    return 7;
+
+  } catch (const std::exception& e) {
+    std::cerr << "migration failed: " << e.what() << std::endl;
+    return 11;
+  }
+}